@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    AnalyzerTap.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Lock-free single producer/single consumer ring of (pre, post) sample pairs.
+
+    The audio thread pushes from processBlock and the editor pulls from its
+    timer; neither side ever waits on the other. Anything that does not fit
+    is dropped, and the processor only pushes while an editor has the tap
+    switched on.
+*/
+class AnalyzerTap
+{
+public:
+    AnalyzerTap()
+    {
+        preSamples.calloc(capacity);
+        postSamples.calloc(capacity);
+    }
+    
+    void setActive (bool shouldBeActive) noexcept   { active.store(shouldBeActive); }
+    bool isActive() const noexcept                  { return active.load(std::memory_order_relaxed); }
+    
+    /** Audio thread only. Double precision samples are narrowed for display. */
+    template <typename SampleType>
+    void push (const SampleType* pre, const SampleType* post, int numSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+        
+        copyIn(pre, preSamples, start1, size1, start2, size2);
+        copyIn(post, postSamples, start1, size1, start2, size2);
+        
+        fifo.finishedWrite(size1 + size2);
+    }
+    
+    /** Consumer thread only; returns how many pairs were read. */
+    int pull (float* pre, float* post, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+        
+        copyOut(preSamples, pre, start1, size1, start2, size2);
+        copyOut(postSamples, post, start1, size1, start2, size2);
+        
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+    
+private:
+    template <typename SampleType>
+    static void copyIn (const SampleType* source, float* ring, int start1, int size1, int start2, int size2) noexcept
+    {
+        auto copy = [] (float* dest, const SampleType* src, int num)
+        {
+            if constexpr (std::is_same_v<SampleType, float>)
+                juce::FloatVectorOperations::copy(dest, src, num);
+            else
+                std::transform(src, src + num, dest, [] (SampleType x) { return (float) x; });
+        };
+
+        if( size1 > 0 )
+            copy(ring + start1, source, size1);
+        if( size2 > 0 )
+            copy(ring + start2, source + size1, size2);
+    }
+    
+    static void copyOut (const float* ring, float* dest, int start1, int size1, int start2, int size2) noexcept
+    {
+        if( size1 > 0 )
+            juce::FloatVectorOperations::copy(dest, ring + start1, size1);
+        if( size2 > 0 )
+            juce::FloatVectorOperations::copy(dest + size1, ring + start2, size2);
+    }
+    
+    static constexpr int capacity = 1 << 15;
+    
+    juce::AbstractFifo fifo { capacity };
+    juce::HeapBlock<float> preSamples, postSamples;
+    std::atomic<bool> active { false };
+    
+    JUCE_DECLARE_NON_COPYABLE (AnalyzerTap)
+};
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    CompressorPieceBatch.cpp
+
+  ==============================================================================
+*/
+
+#include "CompressorPieceBatch.h"
+
+//==============================================================================
+template <typename SampleType>
+void CompressorPieceBatch<SampleType>::prepare (double sampleRate, int maximumBlockSize, int newMaxStreams, int newChannelsPerStream)
+{
+    jassert (newMaxStreams > 0);
+    jassert (newChannelsPerStream == 1 || newChannelsPerStream == 2);
+
+    maxStreams = newMaxStreams;
+    channelsPerStream = newChannelsPerStream;
+    channelPointers.assign((size_t) (maxStreams * channelsPerStream), nullptr);
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (juce::uint32) maximumBlockSize;
+    spec.numChannels = (juce::uint32) (maxStreams * channelsPerStream);
+
+    dsp.prepare(spec);
+}
+
+template <typename SampleType>
+void CompressorPieceBatch<SampleType>::reset ()
+{
+    dsp.reset();
+}
+
+template <typename SampleType>
+void CompressorPieceBatch<SampleType>::setParameters (const CompressorPieceParameters& newParameters) noexcept
+{
+    auto parameters = newParameters;
+    parameters.glueLink = DetectorLink::perChannel;
+    parameters.bandLink = DetectorLink::perChannel;
+    parameters.limiter = false;
+
+    dsp.setParameters(parameters);
+}
+
+template <typename SampleType>
+void CompressorPieceBatch<SampleType>::process (const juce::dsp::AudioBlock<SampleType>* streams, int numStreams)
+{
+    jassert (numStreams <= maxStreams);
+    numStreams = juce::jmin(numStreams, maxStreams);
+
+    if( numStreams <= 0 )
+        return;
+
+    auto numSamples = streams[0].getNumSamples();
+
+    for( int stream = 0; stream < numStreams; ++stream )
+    {
+        jassert (streams[stream].getNumChannels() == (size_t) channelsPerStream);
+        jassert (streams[stream].getNumSamples() == numSamples);
+
+        for( int ch = 0; ch < channelsPerStream; ++ch )
+            channelPointers[(size_t) (stream * channelsPerStream + ch)] = streams[stream].getChannelPointer((size_t) ch);
+    }
+
+    dsp.process(juce::dsp::AudioBlock<SampleType>(channelPointers.data(), (size_t) (numStreams * channelsPerStream), numSamples));
+}
+
+//==============================================================================
+template class CompressorPieceBatch<float>;
+template class CompressorPieceBatch<double>;
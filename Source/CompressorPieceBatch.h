@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    CompressorPieceBatch.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CompressorPieceDSP.h"
+
+//==============================================================================
+/**
+    Runs many independent streams with the same settings through one chain.
+
+    Each stream's channels become consecutive channels of a single
+    CompressorPieceDSP, so every stream-channel is one lane of the crossover
+    and band compressor lane groups, and the amount table, smoothers and
+    coefficient updates are paid once per block for all of them rather than
+    once per stream. Nothing in the chain mixes channels while the detectors
+    are per channel, so each stream comes out as a CompressorPieceDSP of its
+    own would produce it, apart from when the chain sleeps: it only sleeps
+    once every stream has been silent for the tail length. A stream that
+    goes quiet alone keeps running, so when it comes back its band
+    detectors carry on from their decayed state instead of being reseeded,
+    and it differs from a chain of its own until they have caught up.
+
+    Linked detectors and the limiter would couple the streams, so they are
+    always off here.
+*/
+template <typename SampleType>
+class CompressorPieceBatch
+{
+public:
+    CompressorPieceBatch() = default;
+
+    /** Room for up to maxStreams streams of channelsPerStream (1 or 2) channels
+        each, and blocks of up to maximumBlockSize samples.
+    */
+    void prepare (double sampleRate, int maximumBlockSize, int maxStreams, int channelsPerStream);
+
+    /** Call between batches, so the next set of streams starts from rest. */
+    void reset ();
+
+    void setParameters (const CompressorPieceParameters& newParameters) noexcept;
+
+    /** Processes streams in place. Every block needs channelsPerStream channels
+        and the same number of samples; up to the prepared maxStreams blocks.
+    */
+    void process (const juce::dsp::AudioBlock<SampleType>* streams, int numStreams);
+
+    int getLatencySamples () const noexcept            { return dsp.getLatencySamples(); }
+    int getMaxStreams () const noexcept                { return maxStreams; }
+    int getChannelsPerStream () const noexcept         { return channelsPerStream; }
+
+private:
+    CompressorPieceDSP<SampleType> dsp;
+    int maxStreams { 0 }, channelsPerStream { 0 };
+
+    //every stream's channel pointers, gathered into one block without copying
+    std::vector<SampleType*> channelPointers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorPieceBatch)
+};
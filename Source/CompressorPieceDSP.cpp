@@ -0,0 +1,772 @@
+/*
+  ==============================================================================
+
+    CompressorPieceDSP.cpp
+
+  ==============================================================================
+*/
+
+#include "CompressorPieceDSP.h"
+
+namespace
+{
+    //-120 dBFS, for both the input and the settled output
+    constexpr float silenceThreshold = 1.0e-6f;
+
+    constexpr double parameterRampSeconds = 0.02;
+
+    //time for an exponential decay with the given time constant to fall by 120 dB
+    double getSettleSeconds (double timeConstantSeconds)
+    {
+        return timeConstantSeconds * std::log (1.0 / silenceThreshold);
+    }
+}
+
+#if POP_PRINCESS_TELEMETRY
+ #define TELEMETRY(call) do { if( telemetry != nullptr ) telemetry->call; } while (false)
+#else
+ #define TELEMETRY(call)
+#endif
+
+//==============================================================================
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::prepare (const juce::dsp::ProcessSpec& newSpec)
+{
+    spec = newSpec;
+
+    TELEMETRY(prepare(spec.sampleRate));
+
+    if( amountTable == nullptr || amountTableSampleRate != spec.sampleRate )
+    {
+        buildAmountTable();
+    }
+
+    //forget what was last applied so the first block pushes every value
+    waveshaperStep = compressorStep = -1;
+
+    //filter
+    //the per-channel filters share this coefficients object, so it is only
+    //ever written in place, never replaced
+    eqStep = 0;
+    auto& filter = processorChain2.template get<eqIndex>();
+    const auto& flatShelf = (*amountTable)[0].shelf;
+    std::copy(flatShelf.begin(), flatShelf.end(), filter.state->getRawCoefficients());
+
+    processorChain1.prepare(spec);
+    processorChain2.prepare(spec);
+
+    limiter.setLookaheadSeconds(limiterLookahead / 1000.0);
+    limiter.prepare(spec);
+    limiter.setCeilingDecibels(ceiling);
+
+    //every prepare starts at full quality
+    governor.prepare(spec.sampleRate);
+    qualityTier = QualityGovernor::full;
+    TELEMETRY(setQualityTier(qualityTier));
+
+    //saturator begin
+    saturator.prepare(spec);
+    saturator.reset();
+
+    for( size_t phase = 0; phase < oversamplers.size(); ++phase )
+    {
+        auto filterType = phase == 1 ? Oversampler::filterHalfBandFIREquiripple
+                                     : Oversampler::filterHalfBandPolyphaseIIR;
+
+        for( size_t order = 1; order <= (size_t) maxOversamplingOrder; ++order )
+        {
+            auto& os = oversamplers[phase][order - 1];
+            os = std::make_unique<Oversampler>(spec.numChannels, order, filterType, true, true);
+            os->initProcessing(spec.maximumBlockSize);
+        }
+    }
+
+    currentOversampler = nullptr;
+    updateOversampling();
+    updateLatency();
+    //saturator end
+
+    //compressor begin
+    auto& compressor = processorChain1.template get<compressorIndex>();
+    compressor.reset();
+    compressor.setDetectorLink(glueLink);
+    compressor.setRatio(1.15f);
+    compressor.setAttack(1.0f);
+    compressor.setRelease(30.0f);
+    compressor.setThreshold(0.0f);
+
+    //makeup is set once per control period and ramped across it
+    auto& gain3 = processorChain1.template get<compGainIndex>();
+    gain3.setRampDurationSeconds(getEffectiveControlRate() / spec.sampleRate);
+    gain3.reset();
+    //compressor end
+
+    //mb compressor begin
+    crossover.prepare(spec);
+    crossover.reset();
+    crossover.setCrossoverFrequencies(88.3f, 2500.0f);
+
+    //one aligned block holding every band plus the analyzer's input copy, sized
+    //for the largest block the host has promised us
+    arena = juce::dsp::AudioBlock<SampleType>(arenaMemory, numBands * spec.numChannels + 2, spec.maximumBlockSize);
+    arena.clear();
+
+    for( size_t i = 0; i < MBFilterBuffers.size(); ++i )
+    {
+        MBFilterBuffers[i] = arena.getSubsetChannelBlock(i * spec.numChannels, spec.numChannels);
+    }
+
+    using MBComp = MultibandCompressor<SampleType>;
+    compressors.prepare(spec);
+    compressors.reset();
+    compressors.setDetectorLink(bandLink);
+
+    compressors.setRatio(MBComp::lowBand, 66.7f);
+    compressors.setAttack(MBComp::lowBand, 47.8f);
+    compressors.setRelease(MBComp::lowBand, 282.0f);
+    compressors.setThreshold(MBComp::lowBand, -33.8f);
+
+    compressors.setRatio(MBComp::midBand, 66.7f);
+    compressors.setAttack(MBComp::midBand, 22.4f);
+    compressors.setRelease(MBComp::midBand, 282.0f);
+    compressors.setThreshold(MBComp::midBand, -30.2f);
+
+    compressors.setRatio(MBComp::highBand, 100.0f);
+    compressors.setAttack(MBComp::highBand, 13.5f);
+    compressors.setRelease(MBComp::highBand, 282.0f);
+    compressors.setThreshold(MBComp::highBand, -35.5f);
+
+    for( size_t i = 0; i < MBComp::numBands; ++i )
+    {
+        compressors.setInputGainDecibels(i, 5.20f);
+    }
+    compressors.setOutputGainDecibels(MBComp::lowBand, 10.3f);
+    compressors.setOutputGainDecibels(MBComp::midBand, 5.7f);
+    compressors.setOutputGainDecibels(MBComp::highBand, 10.3f);
+    ottMix.reset(spec.sampleRate, parameterRampSeconds);
+    ottMix.setCurrentAndTargetValue(static_cast<SampleType> (amount / 100.0f * 0.75f));
+    bandsActive = false;
+    shelfNeedsReset = false;
+    //mb compressor end
+
+    //the 282 ms band releases dominate; ballistics time constants are
+    //time / 2 pi, and the slowest crossover section (88.3 Hz, Q 0.707)
+    //decays at 2 pi f / 2Q
+    auto releaseSeconds = getSettleSeconds(0.282 / juce::MathConstants<double>::twoPi);
+    auto crossoverSeconds = getSettleSeconds(1.0 / (juce::MathConstants<double>::twoPi * 88.3 * juce::MathConstants<double>::sqrt2 / 2.0));
+    tailSeconds = juce::jmax(releaseSeconds, crossoverSeconds);
+    silentSamples = 0;
+    sleeping = false;
+
+    //start on the current values rather than gliding in from defaults
+    amountSmoothed.reset(spec.sampleRate, parameterRampSeconds);
+    thresholdSmoothed.reset(spec.sampleRate, parameterRampSeconds);
+    makeupSmoothed.reset(spec.sampleRate, parameterRampSeconds);
+    amountSmoothed.setCurrentAndTargetValue(amount);
+    thresholdSmoothed.setCurrentAndTargetValue(threshold);
+    makeupSmoothed.setCurrentAndTargetValue(makeupGain);
+
+    updateControls();
+    saturator.reset();
+    gain3.reset();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::reset ()
+{
+    limiter.setLookaheadSeconds(limiterLookahead / 1000.0);
+    resetStages();
+
+    if( spec.maximumBlockSize > 0 )
+        updateLatency();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::resetStages ()
+{
+    saturator.reset();
+    processorChain1.reset();
+    processorChain2.reset();
+    limiter.reset();
+    crossover.reset();
+    compressors.reset();
+
+    amountSmoothed.setCurrentAndTargetValue(amountSmoothed.getTargetValue());
+    thresholdSmoothed.setCurrentAndTargetValue(thresholdSmoothed.getTargetValue());
+    makeupSmoothed.setCurrentAndTargetValue(makeupSmoothed.getTargetValue());
+    ottMix.setCurrentAndTargetValue(ottMix.getTargetValue());
+
+    if( spec.maximumBlockSize > 0 )
+    {
+        updateControls();
+        saturator.reset();
+        processorChain1.template get<compGainIndex>().reset();
+    }
+    bandsActive = false;
+    shelfNeedsReset = false;
+    silentSamples = 0;
+
+    for( auto& phase : oversamplers )
+        for( auto& os : phase )
+            if( os != nullptr )
+                os->reset();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::setParameters (const Parameters& newParameters) noexcept
+{
+    setAmount(newParameters.amount);
+    setThreshold(newParameters.threshold);
+    setMakeup(newParameters.makeup);
+    setOversampling(newParameters.oversamplingOrder, newParameters.linearPhase);
+    setGlueLink(newParameters.glueLink);
+    setBandLink(newParameters.bandLink);
+    setLimiter(newParameters.limiter, newParameters.ceiling);
+    setLimiterLookahead(newParameters.lookahead);
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::setControlRate (int newControlRateSamples) noexcept
+{
+    controlRate = juce::jmax(1, newControlRateSamples);
+
+    if( spec.maximumBlockSize > 0 )
+        processorChain1.template get<compGainIndex>().setRampDurationSeconds(getEffectiveControlRate() / spec.sampleRate);
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::setQualityGovernor (bool shouldGovern) noexcept
+{
+    if( shouldGovern == governorEnabled )
+        return;
+
+    governorEnabled = shouldGovern;
+
+    //back to full quality, fading in as it would after stepping up
+    if( spec.maximumBlockSize > 0 )
+    {
+        governor.reset();
+        setQualityTier(QualityGovernor::full);
+    }
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::setQualityTier (int newTier) noexcept
+{
+    if( newTier == qualityTier )
+        return;
+
+    qualityTier = newTier;
+    processorChain1.template get<compGainIndex>().setRampDurationSeconds(getEffectiveControlRate() / spec.sampleRate);
+    TELEMETRY(setQualityTier(qualityTier));
+}
+
+template <typename SampleType>
+int CompressorPieceDSP<SampleType>::getEffectiveControlRate () const noexcept
+{
+    return qualityTier >= QualityGovernor::coarseControl ? controlRate * coarseControlFactor : controlRate;
+}
+
+template <typename SampleType>
+int CompressorPieceDSP<SampleType>::getShelfStep () const
+{
+    auto step = getAmountStep();
+    return qualityTier >= QualityGovernor::noShelf && step <= maxSkippableShelfStep ? 0 : step;
+}
+
+template <typename SampleType>
+SampleType CompressorPieceDSP<SampleType>::getCheapCurveTarget () const noexcept
+{
+    return qualityTier >= QualityGovernor::cheapSaturator ? static_cast<SampleType> (1) : SampleType();
+}
+
+template <typename SampleType>
+bool CompressorPieceDSP<SampleType>::isQualityFading () const
+{
+    return shelfStep != getShelfStep() || cheapCurve != getCheapCurveTarget();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::setOversampling (int newOrder, bool useLinearPhase) noexcept
+{
+    oversamplingOrder = juce::jlimit(0, (int) maxOversamplingOrder, newOrder);
+    linearPhase = useLinearPhase;
+
+    //applied straight away so getLatencySamples is right before the next block
+    if( spec.maximumBlockSize > 0 )
+        updateOversampling();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::setLimiter (bool shouldLimit, float newCeilingDb) noexcept
+{
+    ceiling = newCeilingDb;
+
+    if( shouldLimit == limiterEnabled )
+    {
+        if( spec.maximumBlockSize > 0 )
+            limiter.setCeilingDecibels(ceiling);
+
+        return;
+    }
+
+    limiterEnabled = shouldLimit;
+
+    //applied straight away, like oversampling, so the latency is right before the next block
+    if( spec.maximumBlockSize > 0 )
+    {
+        limiter.reset();
+        limiter.setCeilingDecibels(ceiling);
+        updateLatency();
+    }
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::attachTaskPool ()
+{
+    //held for the chain's lifetime, so later bounces find the threads running
+    if( taskPool == nullptr )
+        taskPool = std::make_unique<juce::SharedResourcePointer<TaskPool>>();
+}
+
+//==============================================================================
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::updateCompressor ()
+{
+    auto& compressor = processorChain1.template get<compressorIndex>();
+    auto step = getAmountStep();
+    auto forceUpdate = compressorStep < 0;
+
+    if( step != compressorStep )
+    {
+        compressorStep = step;
+        compressor.setRatio((*amountTable)[(size_t) step].glueRatio);
+    }
+
+    if( forceUpdate || thresholdSmoothed.getCurrentValue() != lastThreshold )
+    {
+        lastThreshold = thresholdSmoothed.getCurrentValue();
+        compressor.setThreshold(lastThreshold);
+    }
+
+    if( forceUpdate || makeupSmoothed.getCurrentValue() != lastMakeup )
+    {
+        lastMakeup = makeupSmoothed.getCurrentValue();
+        auto& gain = processorChain1.template get<compGainIndex>();
+        gain.setGainDecibels(lastMakeup);
+    }
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::updateWaveshaper ()
+{
+    saturator.setCheapCurveAmount(cheapCurve);
+
+    auto step = getAmountStep();
+
+    if( step == waveshaperStep )
+        return;
+
+    waveshaperStep = step;
+    saturator.setDriveGainLinear((*amountTable)[(size_t) step].driveGain);
+    saturator.setOutputGainLinear((*amountTable)[(size_t) step].outGain);
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::updateOversampling ()
+{
+    auto* selected = oversamplingOrder == 0 ? nullptr
+                                            : oversamplers[linearPhase ? 1 : 0][(size_t) oversamplingOrder - 1].get();
+
+    if( selected == currentOversampler )
+        return;
+
+    currentOversampler = selected;
+
+    if( currentOversampler != nullptr )
+        currentOversampler->reset();
+
+    updateLatency();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::updateLatency ()
+{
+    //the saturator's oversampling filters plus the limiter's lookahead
+    latencySamples = (currentOversampler != nullptr ? juce::roundToInt(currentOversampler->getLatencyInSamples()) : 0)
+                   + (limiterEnabled ? limiter.getLatencySamples() : 0);
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::updateEQ ()
+{
+    auto step = shelfStep;
+
+    if( step == eqStep )
+        return;
+
+    eqStep = step;
+    auto& eq = processorChain2.template get<eqIndex>();
+    const auto& shelf = (*amountTable)[(size_t) step].shelf;
+    std::copy(shelf.begin(), shelf.end(), eq.state->getRawCoefficients());
+}
+
+template <typename SampleType>
+double CompressorPieceDSP<SampleType>::getTailLengthSeconds () const noexcept
+{
+    return tailSeconds + (spec.sampleRate > 0.0 ? latencySamples / spec.sampleRate : 0.0);
+}
+
+template <typename SampleType>
+bool CompressorPieceDSP<SampleType>::isSilent (const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    for( size_t ch = 0; ch < block.getNumChannels(); ++ch )
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(block.getChannelPointer(ch), (int) block.getNumSamples());
+
+        if( range.getStart() < -silenceThreshold || range.getEnd() > silenceThreshold )
+            return false;
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+int CompressorPieceDSP<SampleType>::getAmountStep () const
+{
+    return juce::jlimit(0, numAmountSteps - 1, juce::roundToInt(amountSmoothed.getCurrentValue() * 10.0f));
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::updateControls ()
+{
+    shelfStep = getShelfStep();
+    cheapCurve = getCheapCurveTarget();
+
+    updateWaveshaper();
+    updateCompressor();
+    updateEQ();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::advanceControls (int numSamples)
+{
+    amountSmoothed.skip(numSamples);
+    thresholdSmoothed.skip(numSamples);
+    makeupSmoothed.skip(numSamples);
+
+    //the shelf may move as many steps as a full-range Amount glide would, so
+    //glides are followed exactly and tier changes fade over the same time
+    auto fadeSamples = parameterRampSeconds * spec.sampleRate;
+    auto maxShelfSteps = juce::jmax(1, (int) std::ceil(numAmountSteps * numSamples / fadeSamples));
+    shelfStep += juce::jlimit(-maxShelfSteps, maxShelfSteps, getShelfStep() - shelfStep);
+
+    auto cheapTarget = getCheapCurveTarget();
+    auto cheapStep = static_cast<SampleType> (numSamples / fadeSamples);
+    cheapCurve = cheapCurve < cheapTarget ? juce::jmin(cheapTarget, cheapCurve + cheapStep)
+                                          : juce::jmax(cheapTarget, cheapCurve - cheapStep);
+
+    updateWaveshaper();
+    updateCompressor();
+    updateEQ();
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::buildAmountTable ()
+{
+    //every instance at this rate and precision needs the same table
+    auto sampleRate = spec.sampleRate;
+    amountTable = sharedResources->get<AmountTable>(sampleRate, 0, [sampleRate] { return createAmountTable(sampleRate); });
+
+    amountTableSampleRate = spec.sampleRate;
+    //the shelf is 0.87 dB deep at Amount 100 and scales linearly below it
+    maxSkippableShelfStep = (int) std::floor(QualityGovernor::shelfSkipDecibels / 0.87f * 100.0f * 10.0f);
+}
+
+template <typename SampleType>
+std::shared_ptr<typename CompressorPieceDSP<SampleType>::AmountTable> CompressorPieceDSP<SampleType>::createAmountTable (double sampleRate)
+{
+    auto table = std::make_shared<AmountTable>(numAmountSteps);
+
+    for( int step = 0; step < numAmountSteps; ++step )
+    {
+        auto amountValue = step / 10.0;
+        auto& entry = (*table)[(size_t) step];
+
+        entry.driveGain = (SampleType) juce::Decibels::decibelsToGain(amountValue / 100.0 * 35.0);
+        entry.outGain = (SampleType) juce::Decibels::decibelsToGain(amountValue / 100.0 * (0-35.0));
+        entry.glueRatio = (SampleType) (amountValue / 100.0 * (4.0-1.15) + 1.15);
+
+        auto coefs = FilterCoefs::makeHighShelf(sampleRate, (SampleType) 2500.0, (SampleType) 0.71, (SampleType) juce::Decibels::decibelsToGain(amountValue / 100.0 * (0-0.87)));
+        jassert (coefs->coefficients.size() == (int) entry.shelf.size());
+        std::copy(coefs->coefficients.begin(), coefs->coefficients.end(), entry.shelf.begin());
+    }
+
+    return table;
+}
+
+//==============================================================================
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::process (const juce::dsp::AudioBlock<SampleType>& input)
+{
+    //JUCE's filters are built without snapToZero (JUCE_DSP_ENABLE_SNAP_TO_ZERO=0),
+    //so for every caller the CPU flushes denormals instead
+    juce::ScopedNoDenormals noDenormals;
+
+    auto startTicks = governorEnabled ? juce::Time::getHighResolutionTicks() : 0;
+
+    updateOversampling();
+
+    amountSmoothed.setTargetValue(amount);
+    thresholdSmoothed.setTargetValue(threshold);
+    makeupSmoothed.setTargetValue(makeupGain);
+    ottMix.setTargetValue(static_cast<SampleType> (amount / 100.0f * 0.75f));
+    processorChain1.template get<compressorIndex>().setDetectorLink(glueLink);
+    compressors.setDetectorLink(bandLink);
+
+    //the arena is never resized here: extra channels are left untouched and
+    //blocks longer than prepare promised are processed in chunks
+    jassert (spec.maximumBlockSize > 0);
+
+    auto block = input.getSubsetChannelBlock(0, juce::jmin(input.getNumChannels(), (size_t) spec.numChannels));
+    auto inputSilent = isSilent(block);
+
+    if( sleeping )
+    {
+        if( inputSilent )
+        {
+            //nothing is ringing, so parameter moves can land straight away
+            if( amountSmoothed.isSmoothing() || thresholdSmoothed.isSmoothing() || makeupSmoothed.isSmoothing() )
+                resetStages();
+
+            block.clear();
+
+            if( analyzerTap != nullptr && analyzerTap->isActive() )
+                analyzerTap->push(block.getChannelPointer(0), block.getChannelPointer(0), (int) block.getNumSamples());
+
+            return;
+        }
+
+        sleeping = false;
+    }
+
+    //one record per host block; every chunk, tile and segment below adds its
+    //stage times to it
+    TELEMETRY(beginBlock((int) block.getNumSamples()));
+
+    for( size_t start = 0; start < block.getNumSamples(); start += spec.maximumBlockSize )
+    {
+        auto chunk = block.getSubBlock(start, juce::jmin((size_t) spec.maximumBlockSize, block.getNumSamples() - start));
+
+        if( ! amountSmoothed.isSmoothing() && ! thresholdSmoothed.isSmoothing() && ! makeupSmoothed.isSmoothing()
+            && ! isQualityFading() )
+        {
+            processTiles(chunk);
+            continue;
+        }
+
+        auto segmentSize = (size_t) getEffectiveControlRate();
+
+        for( size_t offset = 0; offset < chunk.getNumSamples(); offset += segmentSize )
+        {
+            auto segment = chunk.getSubBlock(offset, juce::jmin(segmentSize, chunk.getNumSamples() - offset));
+            advanceControls((int) segment.getNumSamples());
+            processChunk(segment);
+        }
+    }
+
+    //once per host block, so the output is the same however it was tiled
+    crossover.snapToZero();
+
+    TELEMETRY(endBlock());
+
+    if( ! inputSilent )
+    {
+        silentSamples = 0;
+    }
+    else
+    {
+        silentSamples += (juce::int64) block.getNumSamples();
+
+        if( silentSamples >= (juce::int64) (getTailLengthSeconds() * spec.sampleRate) && isSilent(block) )
+        {
+            resetStages();
+            sleeping = true;
+        }
+    }
+
+    if( governorEnabled )
+        setQualityTier(governor.update(juce::Time::getHighResolutionTicks() - startTicks, (int) block.getNumSamples()));
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::processTiles (juce::dsp::AudioBlock<SampleType>& chunk)
+{
+    auto numSamples = chunk.getNumSamples();
+
+    //big chunks are the parallel path's work units, so they are left whole
+    if( tileSize == 0 || numSamples <= (size_t) tileSize
+        || (parallelProcessing && numSamples >= minParallelSamples) )
+    {
+        processChunk(chunk);
+        return;
+    }
+
+    for( size_t start = 0; start < numSamples; start += (size_t) tileSize )
+    {
+        auto tile = chunk.getSubBlock(start, juce::jmin((size_t) tileSize, numSamples - start));
+        processChunk(tile);
+    }
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::processChunk (juce::dsp::AudioBlock<SampleType>& block)
+{
+    auto numSamples = block.getNumSamples();
+    auto numChannels = block.getNumChannels();
+
+    //only pay for the analyzer copy while an editor is listening
+    auto tapActive = analyzerTap != nullptr && analyzerTap->isActive();
+    auto* tapInput = arena.getChannelPointer(numBands * spec.numChannels);
+
+    if( tapActive )
+        juce::FloatVectorOperations::copy(tapInput, block.getChannelPointer(0), (int) numSamples);
+
+    if( currentOversampler != nullptr )
+    {
+        auto oversampledBlock = currentOversampler->processSamplesUp(block);
+        saturator.process(juce::dsp::ProcessContextReplacing <SampleType> (oversampledBlock));
+        currentOversampler->processSamplesDown(block);
+    }
+    else
+    {
+        saturator.process(juce::dsp::ProcessContextReplacing <SampleType> (block));
+    }
+
+    processorChain1.process(juce::dsp::ProcessContextReplacing <SampleType> (block));
+    TELEMETRY(endStage(Telemetry::saturator));
+
+    // mb comp begin
+    if( ! ottMix.isSmoothing() && ottMix.getTargetValue() == SampleType() )
+    {
+        bandsActive = false;
+    }
+    else
+    {
+        std::array<juce::dsp::AudioBlock<SampleType>, numBands> bands;
+        for( size_t i = 0; i < bands.size(); ++i )
+        {
+            bands[i] = MBFilterBuffers[i].getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+        }
+
+        if( ! bandsActive )
+            crossover.reset();
+
+        splitBands(block, bands);
+        TELEMETRY(endStage(Telemetry::crossover));
+
+        if( ! bandsActive )
+        {
+            compressors.seedEnvelopes(bands);
+            bandsActive = true;
+        }
+
+        compressBands(bands);
+        TELEMETRY(endStage(Telemetry::bandCompressors));
+
+        auto addFilterBand = [](auto& outputBlock, const auto& source, SampleType mix)
+        {
+            outputBlock.addProductOf(source, mix);
+        };
+
+        if( ottMix.isSmoothing() )
+        {
+            auto* ramp = arena.getChannelPointer(numBands * spec.numChannels + 1);
+
+            for( size_t i = 0; i < numSamples; ++i )
+                ramp[i] = ottMix.getNextValue();
+
+            for( auto& band : bands )
+                for( size_t ch = 0; ch < numChannels; ++ch )
+                    juce::FloatVectorOperations::addWithMultiply(block.getChannelPointer(ch), band.getChannelPointer(ch), ramp, (int) numSamples);
+        }
+        else
+        {
+            addFilterBand(block, bands[0], ottMix.getTargetValue());
+            addFilterBand(block, bands[1], ottMix.getTargetValue());
+            addFilterBand(block, bands[2], ottMix.getTargetValue());
+        }
+        TELEMETRY(endStage(Telemetry::bandSum));
+    }
+    //mb comp end
+
+    if( eqStep == 0 )
+    {
+        shelfNeedsReset = true;
+    }
+    else
+    {
+        if( shelfNeedsReset )
+        {
+            processorChain2.reset();
+            shelfNeedsReset = false;
+        }
+
+        processorChain2.process(juce::dsp::ProcessContextReplacing <SampleType> (block));
+    }
+    TELEMETRY(endStage(Telemetry::eq));
+
+    if( limiterEnabled )
+        limiter.process(juce::dsp::ProcessContextReplacing <SampleType> (block));
+    TELEMETRY(endStage(Telemetry::limiter));
+
+    if( tapActive )
+        analyzerTap->push(tapInput, block.getChannelPointer(0), (int) numSamples);
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::splitBands (const juce::dsp::AudioBlock<SampleType>& block,
+                                                 std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands)
+{
+    auto numChannels = block.getNumChannels();
+
+    if( parallelProcessing && taskPool != nullptr && block.getNumSamples() >= minParallelSamples && numChannels > 1 )
+    {
+        auto& pool = **taskPool;
+        auto numTasks = juce::jmin((int) numChannels, pool.getNumThreads());
+        auto channelsPerTask = (numChannels + (size_t) numTasks - 1) / (size_t) numTasks;
+
+        auto task = [&] (int index)
+        {
+            juce::ScopedNoDenormals noDenormals;
+            crossover.processChannels(block, bands, (size_t) index * channelsPerTask, channelsPerTask);
+        };
+
+        if( pool.tryRun(numTasks, task) )
+            return;
+    }
+
+    crossover.process(block, bands);
+}
+
+template <typename SampleType>
+void CompressorPieceDSP<SampleType>::compressBands (std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands)
+{
+    if( parallelProcessing && taskPool != nullptr && bands[0].getNumSamples() >= minParallelSamples )
+    {
+        auto task = [&] (int band)
+        {
+            juce::ScopedNoDenormals noDenormals;
+            compressors.processBands(bands, (size_t) band, 1);
+        };
+
+        if( (*taskPool)->tryRun(numBands, task) )
+            return;
+    }
+
+    compressors.process(bands);
+}
+
+//==============================================================================
+template class CompressorPieceDSP<float>;
+template class CompressorPieceDSP<double>;
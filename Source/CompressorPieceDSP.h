@@ -0,0 +1,355 @@
+/*
+  ==============================================================================
+
+    CompressorPieceDSP.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "Crossover.h"
+#include "MultibandCompressor.h"
+#include "GlueCompressor.h"
+#include "LookaheadLimiter.h"
+#include "Saturator.h"
+#include "AnalyzerTap.h"
+#include "Telemetry.h"
+#include "TaskPool.h"
+#include "QualityGovernor.h"
+#include "SharedResources.h"
+
+//==============================================================================
+/** Every user-facing parameter, read together at the start of a block. */
+struct CompressorPieceParameters
+{
+    float amount { 0.0f };
+    float threshold { 0.0f };
+    float makeup { 0.0f };
+    int oversamplingOrder { 0 };
+    bool linearPhase { false };
+    DetectorLink glueLink { DetectorLink::perChannel };
+    DetectorLink bandLink { DetectorLink::perChannel };
+    bool limiter { false };
+    float ceiling { -0.3f };
+    float lookahead { 1.5f };
+};
+
+//==============================================================================
+/**
+    The whole Pop Princess signal chain without any plugin or GUI code.
+
+    CompressorPieceAudioProcessor forwards its parameters and buffers to one
+    of these; the offline tools drive it directly. Parameter setters only
+    store values, they are applied at the start of the next process call.
+
+    Every stage runs in SampleType, so a double precision host gets a double
+    precision chain with no conversions. Instantiated for float and double.
+*/
+template <typename SampleType>
+class CompressorPieceDSP
+{
+public:
+    CompressorPieceDSP() = default;
+
+    using Parameters = CompressorPieceParameters;
+
+    //==============================================================================
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset ();
+
+    /** Processes any number of samples, in chunks of at most the prepared block size. */
+    void process (const juce::dsp::AudioBlock<SampleType>& block);
+
+    //==============================================================================
+    void setAmount (float newAmount) noexcept           { amount = newAmount; }
+    void setThreshold (float newThresholdDb) noexcept   { threshold = newThresholdDb; }
+    void setMakeup (float newMakeupDb) noexcept         { makeupGain = newMakeupDb; }
+
+    /** How the glue compressor and the band compressors detect across channels. */
+    void setGlueLink (DetectorLink newLink) noexcept    { glueLink = newLink; }
+    void setBandLink (DetectorLink newLink) noexcept    { bandLink = newLink; }
+
+    /** Brickwall limiter at the end of the chain. Turning it on adds its
+        lookahead to getLatencySamples straight away.
+    */
+    void setLimiter (bool shouldLimit, float newCeilingDb) noexcept;
+
+    /** The limiter's lookahead in milliseconds, up to
+        LookaheadLimiter::maxLookaheadSeconds. Only taken up by the next
+        prepare or reset, along with getLatencySamples: a new lookahead
+        empties the limiter's delay line, which mid-stream would drop up to
+        5 ms of audio.
+    */
+    void setLimiterLookahead (float newLookaheadMs) noexcept { limiterLookahead = newLookaheadMs; }
+
+    void setParameters (const Parameters& newParameters) noexcept;
+
+    /** order 0 runs the saturator at the base rate, 1-3 at 2x, 4x or 8x. */
+    void setOversampling (int newOrder, bool useLinearPhase) noexcept;
+
+    /** Amount, threshold and makeup glide to new values over 20 ms. While they
+        do, the chain runs in segments of this many samples: derived values
+        (the glue ratio and threshold, the shelf, the saturator's target
+        gains) are recomputed once per segment, and the saturator, makeup
+        gain and band mix ramp per sample between those points.
+    */
+    void setControlRate (int newControlRateSamples) noexcept;
+    int getControlRate () const noexcept                { return controlRate; }
+
+    /** Outside parameter glides, each chunk runs through the whole chain in
+        tiles of this many samples, so the bands and every stage's scratch
+        stay in L1 from one stage to the next rather than streaming a full
+        host block through memory once per stage. 0, the default, processes
+        whole chunks; anything else is at least
+        MultibandCompressor::seedSamples. Every stage is sample-sequential
+        and states are only flushed to zero once per host block, so the
+        output is bit for bit the same at any tile size. Ignored while
+        parallel processing splits large chunks.
+    */
+    void setTileSize (int newTileSizeSamples) noexcept
+    {
+        tileSize = newTileSizeSamples <= 0 ? 0 : juce::jmax(newTileSizeSamples, (int) MultibandCompressor<SampleType>::seedSamples);
+    }
+
+    int getTileSize () const noexcept                   { return tileSize; }
+
+    /** Latency of the current oversampling and limiter settings, in base-rate samples. */
+    int getLatencySamples () const noexcept             { return latencySamples; }
+
+    /** How long the output can keep changing after the input goes silent:
+        the slowest of the band detectors' release and the crossover's
+        ringing, plus the latency.
+    */
+    double getTailLengthSeconds () const noexcept;
+
+    /** True while silent input is being skipped rather than processed. */
+    bool isSleeping () const noexcept                   { return sleeping; }
+
+    /** Joins the process-wide TaskPool, starting its threads if no other
+        chain has yet. Until this has been called setParallelProcessing has
+        no effect. It may throw, so call it while preparing, never from the
+        audio thread or a noexcept callback.
+    */
+    void attachTaskPool ();
+
+    /** Lets chunks of at least minParallelSamples split the crossover across
+        channels and the band compressors across bands on the TaskPool from
+        attachTaskPool. That waits on locks, so only turn it on for offline
+        rendering; the processor follows isNonRealtime(). Only sets a flag,
+        so it is safe from any thread; process only reads it.
+    */
+    void setParallelProcessing (bool shouldUseThreads) noexcept { parallelProcessing = shouldUseThreads; }
+
+    /** Lets the chain time each block against its deadline and step down
+        through the QualityGovernor tiers while it keeps running late, and
+        back up once there is room again. The shelf and saturator fade into
+        and out of their cheaper forms over 20 ms. Off, the chain always runs
+        at full quality; the processor turns it on unless isNonRealtime().
+    */
+    void setQualityGovernor (bool shouldGovern) noexcept;
+    int getQualityTier () const noexcept                { return qualityTier; }
+
+    /** Channel 0 of the input and output is pushed here while it is active. */
+    void setAnalyzerTap (AnalyzerTap* newTap) noexcept  { analyzerTap = newTap; }
+
+    const juce::dsp::ProcessSpec& getProcessSpec () const noexcept { return spec; }
+
+   #if POP_PRINCESS_TELEMETRY
+    /** Where stage timings go; nothing is timed without one. */
+    void setTelemetry (Telemetry* newTelemetry) noexcept { telemetry = newTelemetry; }
+   #endif
+
+private:
+    //==============================================================================
+    void updateCompressor ();
+    void updateWaveshaper ();
+    void updateEQ ();
+    void updateOversampling ();
+    void updateLatency ();
+
+    //reset() without taking up a new lookahead, so sleeping never moves the latency
+    void resetStages ();
+
+    //applies the smoothed values, after moving them on by numSamples; the
+    //quality fades move on by numSamples too, or jump to their targets
+    void updateControls ();
+    void advanceControls (int numSamples);
+
+    void setQualityTier (int newTier) noexcept;
+    int getEffectiveControlRate () const noexcept;
+    int getShelfStep () const;
+    SampleType getCheapCurveTarget () const noexcept;
+    bool isQualityFading () const;
+
+    void processTiles (juce::dsp::AudioBlock<SampleType>& chunk);
+    void processChunk (juce::dsp::AudioBlock<SampleType>& block);
+    void splitBands (const juce::dsp::AudioBlock<SampleType>& block, std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands);
+    void compressBands (std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands);
+
+    static bool isSilent (const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    juce::dsp::ProcessSpec spec { 0.0, 0, 0 };
+
+    float amount { 0.0f }, threshold { 0.0f }, makeupGain { 0.0f };
+    juce::SmoothedValue<float> amountSmoothed, thresholdSmoothed, makeupSmoothed;
+    int controlRate { 32 };
+
+    //off: timing the chain's own stages on 4096-sample stereo blocks, tiles
+    //of 64-256 ran 4-12% slower than whole blocks and 512-2048 no faster.
+    //Retune with Benchmark --tiles
+    enum
+    {
+        defaultTileSize = 0
+    };
+
+    int tileSize { defaultTileSize };
+
+    //the coarseControl tier runs glides in segments this many times longer
+    enum
+    {
+        coarseControlFactor = 4
+    };
+
+    QualityGovernor governor;
+    bool governorEnabled { false };
+    int qualityTier { QualityGovernor::full };
+
+    //where the tier fades have got to: the Amount step the shelf is on, which
+    //walks to 0 no faster than an Amount glide would, and the saturator's mix
+    //towards its cheap curve
+    int shelfStep { 0 };
+    SampleType cheapCurve { 0 };
+    int oversamplingOrder { 0 };
+    bool linearPhase { false };
+    DetectorLink glueLink { DetectorLink::perChannel }, bandLink { DetectorLink::perChannel };
+    bool limiterEnabled { false };
+    float ceiling { -0.3f }, limiterLookahead { 1.5f };
+    int latencySamples { 0 };
+
+    AnalyzerTap* analyzerTap { nullptr };
+
+   #if POP_PRINCESS_TELEMETRY
+    Telemetry* telemetry { nullptr };
+   #endif
+
+    enum
+    {
+        compressorIndex,
+        compGainIndex,
+    };
+
+    enum
+    {
+        eqIndex
+    };
+
+    using Filter = juce::dsp::IIR::Filter<SampleType>;
+    using FilterCoefs = juce::dsp::IIR::Coefficients<SampleType>;
+
+    //everything derived from Amount, precomputed for each of its 0.1 steps so the
+    //audio thread only ever indexes into this and copies values in place; one
+    //table per sample rate is shared by every instance in the process
+    enum
+    {
+        numAmountSteps = 1001
+    };
+
+    struct AmountStep
+    {
+        SampleType driveGain, outGain, glueRatio;
+        std::array<SampleType, 5> shelf;
+    };
+
+    using AmountTable = std::vector<AmountStep>;
+
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    std::shared_ptr<const AmountTable> amountTable;
+    double amountTableSampleRate { 0.0 };
+
+    //the highest step whose shelf is within QualityGovernor::shelfSkipDecibels of flat
+    int maxSkippableShelfStep { 0 };
+
+    void buildAmountTable ();
+    static std::shared_ptr<AmountTable> createAmountTable (double sampleRate);
+    int getAmountStep () const;
+
+    //last values handed to the DSP, so setters only run when something moved
+    int waveshaperStep { -1 }, compressorStep { -1 }, eqStep { -1 };
+    float lastThreshold { 0.0f }, lastMakeup { 0.0f };
+
+    using MBFilter = ThreeBandCrossover<SampleType>;
+    MBFilter crossover;
+
+    //band and scratch storage, allocated once in prepare for the prepared
+    //channel count and only ever viewed through AudioBlocks afterwards so
+    //process never allocates: numBands channel groups, then one channel
+    //holding the analyzer's copy of the input and one for the band mix ramp
+    enum
+    {
+        numBands = 3
+    };
+
+    juce::HeapBlock<char> arenaMemory;
+    juce::dsp::AudioBlock<SampleType> arena;
+    std::array<juce::dsp::AudioBlock<SampleType>, numBands> MBFilterBuffers;
+
+    //the band mix is ramped, and once it has settled on 0 the crossover and
+    //band compressors are skipped until it moves again; on the way back in
+    //the crossover starts from rest and the detectors are seeded from the
+    //start of the first chunk, while the mix ramps up from 0
+    juce::SmoothedValue<SampleType> ottMix;
+    bool bandsActive { false };
+
+    //after a tail length of silent input with a silent output every stage has
+    //decayed to where reset() puts it, so the chain sleeps: blocks are just
+    //checked and cleared until a non-silent one arrives, which is processed
+    //normally from that reset state
+    double tailSeconds { 0.0 };
+    juce::int64 silentSamples { 0 };
+    bool sleeping { false };
+
+    //at Amount 0 the shelf is exactly unity gain, and a unity biquad's
+    //settled state is all zeros, so it is skipped and reset on the way back
+    bool shelfNeedsReset { false };
+
+    //drive, waveshaper and out gain, run at the oversampled rate
+    Saturator<SampleType> saturator;
+
+    //one oversampler per factor above 1x, for both filter types, so switching
+    //never allocates; nullptr means the saturator runs at the base rate
+    enum
+    {
+        maxOversamplingOrder = 3
+    };
+
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+    std::array<std::array<std::unique_ptr<Oversampler>, maxOversamplingOrder>, 2> oversamplers;
+    Oversampler* currentOversampler { nullptr };
+
+    juce::dsp::ProcessorChain<GlueCompressor<SampleType>, //begin compressor
+                              juce::dsp::Gain<SampleType> //end of compressor
+    > processorChain1;
+
+    //band in-gain, compressor and out-gain, all bands and channels in one pass
+    MultibandCompressor<SampleType> compressors;
+
+    juce::dsp::ProcessorChain<
+                              juce::dsp::ProcessorDuplicator<Filter, FilterCoefs> //high shelf eq
+    > processorChain2;
+
+    //last stage; runs on every chunk while enabled, shelf or not
+    LookaheadLimiter<SampleType> limiter;
+
+    //below this many samples the hand-off costs more than the threads save
+    enum
+    {
+        minParallelSamples = 4096
+    };
+
+    std::atomic<bool> parallelProcessing { false };
+    std::unique_ptr<juce::SharedResourcePointer<TaskPool>> taskPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorPieceDSP)
+};
@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    Crossover.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/**
+    Three band Linkwitz-Riley crossover.
+
+    Both splits use the filter's dual output form, so each lowpass/highpass
+    pair shares one set of state, and the low band is run through an allpass
+    at the upper crossover frequency so all three bands stay phase coherent.
+
+    The filters are the same TPT state variable sections as
+    juce::dsp::LinkwitzRileyFilter, but channels are processed laneWidth at
+    a time: each channel group is transposed into a sample-major tile and
+    every band of every channel in it comes out of one pass over fixed-size
+    lane arrays, which the compiler vectorises. Any channel count works;
+    the last group is padded with silent lanes.
+*/
+template <typename SampleType>
+class ThreeBandCrossover
+{
+public:
+    static constexpr size_t laneWidth = 8;
+    static constexpr size_t tileSize = 32;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0);
+        jassert (spec.numChannels > 0);
+
+        sampleRate = spec.sampleRate;
+        numChannels = spec.numChannels;
+        numGroups = (numChannels + laneWidth - 1) / laneWidth;
+
+        for( auto* lanes : { &lowMid1, &lowMid2, &lowMid3, &lowMid4, &allpass1, &allpass2, &midHigh1, &midHigh2, &midHigh3, &midHigh4 } )
+        {
+            lanes->assign(numGroups * laneWidth, SampleType());
+        }
+
+        update();
+    }
+
+    void reset()
+    {
+        for( auto* lanes : { &lowMid1, &lowMid2, &lowMid3, &lowMid4, &allpass1, &allpass2, &midHigh1, &midHigh2, &midHigh3, &midHigh4 } )
+        {
+            std::fill(lanes->begin(), lanes->end(), SampleType());
+        }
+    }
+
+    /** Flushes states below -160 dB to zero, the same threshold as
+        juce::dsp::util::snapToZero. process never does this itself, so its
+        output doesn't depend on how the input is split into calls; call it
+        once per host block instead. Not while another thread is processing.
+    */
+    void snapToZero() noexcept
+    {
+        for( auto* lanes : { &lowMid1, &lowMid2, &lowMid3, &lowMid4, &allpass1, &allpass2, &midHigh1, &midHigh2, &midHigh3, &midHigh4 } )
+        {
+            for( auto& state : *lanes )
+                if( ! (state < static_cast<SampleType> (-1.0e-8) || state > static_cast<SampleType> (1.0e-8)) )
+                    state = 0;
+        }
+    }
+
+    void setCrossoverFrequencies (SampleType lowMidFrequency, SampleType midHighFrequency)
+    {
+        lowMidCutoff = lowMidFrequency;
+        midHighCutoff = midHighFrequency;
+        update();
+    }
+
+    /** Splits input into the low, mid and high blocks, which must not alias it. */
+    void process (const juce::dsp::AudioBlock<SampleType>& input,
+                  std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands) noexcept
+    {
+        processChannels(input, bands, 0, numChannels);
+    }
+
+    /** Splits only channels firstChannel to firstChannel + numChannelsToProcess - 1.
+        Channels share no state, so separate ranges can be split on separate
+        threads at the same time.
+    */
+    void processChannels (const juce::dsp::AudioBlock<SampleType>& input,
+                          std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands,
+                          size_t firstChannel, size_t numChannelsToProcess) noexcept
+    {
+        auto endChannel = juce::jmin(input.getNumChannels(), numChannels, firstChannel + numChannelsToProcess);
+        auto numSamples = input.getNumSamples();
+
+        for( auto groupStart = firstChannel; groupStart < endChannel; groupStart += laneWidth )
+            processGroup(input, bands, groupStart, juce::jmin(laneWidth, endChannel - groupStart), numSamples);
+    }
+
+private:
+    //coefficients of one two-pole section
+    struct Section
+    {
+        SampleType g = 0, h = 0;
+    };
+
+    static constexpr SampleType R2 = static_cast<SampleType> (1.4142135623730951);
+
+    Section makeSection (SampleType cutoff) const
+    {
+        Section section;
+        section.g = static_cast<SampleType> (std::tan (juce::MathConstants<double>::pi * cutoff / sampleRate));
+        section.h = static_cast<SampleType> (1.0) / (static_cast<SampleType> (1.0) + R2 * section.g + section.g * section.g);
+        return section;
+    }
+
+    void update()
+    {
+        lowMid = makeSection(lowMidCutoff);
+        midHigh = makeSection(midHighCutoff);
+    }
+
+    void processGroup (const juce::dsp::AudioBlock<SampleType>& input,
+                       std::array<juce::dsp::AudioBlock<SampleType>, 3>& bands,
+                       size_t firstChannel, size_t numActive, size_t numSamples) noexcept
+    {
+        alignas (32) SampleType lm1[laneWidth], lm2[laneWidth], lm3[laneWidth], lm4[laneWidth];
+        alignas (32) SampleType ap1[laneWidth], ap2[laneWidth];
+        alignas (32) SampleType mh1[laneWidth], mh2[laneWidth], mh3[laneWidth], mh4[laneWidth];
+
+        //only the active lanes are read and written back, so concurrent calls on
+        //other channels never touch the same state
+        auto load = [firstChannel, numActive] (SampleType* dst, const std::vector<SampleType>& src)
+        {
+            std::fill(dst, dst + laneWidth, SampleType());
+            std::copy(src.begin() + (std::ptrdiff_t) firstChannel, src.begin() + (std::ptrdiff_t) (firstChannel + numActive), dst);
+        };
+
+        load(lm1, lowMid1); load(lm2, lowMid2); load(lm3, lowMid3); load(lm4, lowMid4);
+        load(ap1, allpass1); load(ap2, allpass2);
+        load(mh1, midHigh1); load(mh2, midHigh2); load(mh3, midHigh3); load(mh4, midHigh4);
+
+        const auto g1 = lowMid.g, h1 = lowMid.h, g2 = midHigh.g, h2 = midHigh.h;
+
+        //lanes past the last channel stay silent
+        alignas (32) SampleType tile[tileSize][laneWidth] = {};
+        alignas (32) SampleType lowTile[tileSize][laneWidth] = {};
+        alignas (32) SampleType midTile[tileSize][laneWidth] = {};
+        alignas (32) SampleType highTile[tileSize][laneWidth] = {};
+
+        for( size_t start = 0; start < numSamples; start += tileSize )
+        {
+            auto tileLength = juce::jmin(tileSize, numSamples - start);
+
+            for( size_t lane = 0; lane < numActive; ++lane )
+            {
+                auto* src = input.getChannelPointer(firstChannel + lane) + start;
+                for( size_t i = 0; i < tileLength; ++i )
+                    tile[i][lane] = src[i];
+            }
+
+            for( size_t i = 0; i < tileLength; ++i )
+            {
+                for( size_t lane = 0; lane < laneWidth; ++lane )
+                {
+                    //low/mid split, dual output
+                    auto yH = (tile[i][lane] - (R2 + g1) * lm1[lane] - lm2[lane]) * h1;
+                    auto yB = g1 * yH + lm1[lane];
+                    lm1[lane] = g1 * yH + yB;
+                    auto yL = g1 * yB + lm2[lane];
+                    lm2[lane] = g1 * yB + yL;
+
+                    auto yH2 = (yL - (R2 + g1) * lm3[lane] - lm4[lane]) * h1;
+                    auto yB2 = g1 * yH2 + lm3[lane];
+                    lm3[lane] = g1 * yH2 + yB2;
+                    auto yL2 = g1 * yB2 + lm4[lane];
+                    lm4[lane] = g1 * yB2 + yL2;
+
+                    auto lowSplit = yL2;
+                    auto highSplit = yL - R2 * yB + yH - yL2;
+
+                    //low band allpass at the mid/high frequency
+                    auto aH = (lowSplit - (R2 + g2) * ap1[lane] - ap2[lane]) * h2;
+                    auto aB = g2 * aH + ap1[lane];
+                    ap1[lane] = g2 * aH + aB;
+                    auto aL = g2 * aB + ap2[lane];
+                    ap2[lane] = g2 * aB + aL;
+
+                    lowTile[i][lane] = aL - R2 * aB + aH;
+
+                    //mid/high split, dual output
+                    auto mH = (highSplit - (R2 + g2) * mh1[lane] - mh2[lane]) * h2;
+                    auto mB = g2 * mH + mh1[lane];
+                    mh1[lane] = g2 * mH + mB;
+                    auto mL = g2 * mB + mh2[lane];
+                    mh2[lane] = g2 * mB + mL;
+
+                    auto mH2 = (mL - (R2 + g2) * mh3[lane] - mh4[lane]) * h2;
+                    auto mB2 = g2 * mH2 + mh3[lane];
+                    mh3[lane] = g2 * mH2 + mB2;
+                    auto mL2 = g2 * mB2 + mh4[lane];
+                    mh4[lane] = g2 * mB2 + mL2;
+
+                    midTile[i][lane] = mL2;
+                    highTile[i][lane] = mL - R2 * mB + mH - mL2;
+                }
+            }
+
+            for( size_t lane = 0; lane < numActive; ++lane )
+            {
+                auto* low = bands[0].getChannelPointer(firstChannel + lane) + start;
+                auto* mid = bands[1].getChannelPointer(firstChannel + lane) + start;
+                auto* high = bands[2].getChannelPointer(firstChannel + lane) + start;
+
+                for( size_t i = 0; i < tileLength; ++i )
+                {
+                    low[i] = lowTile[i][lane];
+                    mid[i] = midTile[i][lane];
+                    high[i] = highTile[i][lane];
+                }
+            }
+        }
+
+        auto store = [firstChannel, numActive] (std::vector<SampleType>& dst, const SampleType* src)
+        {
+            std::copy(src, src + numActive, dst.begin() + (std::ptrdiff_t) firstChannel);
+        };
+
+        store(lowMid1, lm1); store(lowMid2, lm2); store(lowMid3, lm3); store(lowMid4, lm4);
+        store(allpass1, ap1); store(allpass2, ap2);
+        store(midHigh1, mh1); store(midHigh2, mh2); store(midHigh3, mh3); store(midHigh4, mh4);
+    }
+
+    SampleType lowMidCutoff = 88.3f, midHighCutoff = 2500.0f;
+    Section lowMid, midHigh;
+
+    //per-channel filter state, one lane per channel
+    std::vector<SampleType> lowMid1, lowMid2, lowMid3, lowMid4, allpass1, allpass2, midHigh1, midHigh2, midHigh3, midHigh4;
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 0, numGroups = 0;
+};
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    DetectorLink.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/** How a compressor stage's detector treats the channels.
+
+    perChannel runs one envelope per channel, each channel with its own gain.
+    maximum and sum run a single envelope per stage (per band for the band
+    compressors) on the loudest channel or on the channels' summed level,
+    and apply that one gain to every channel. That keeps the image still,
+    and it pays for the log/exp of the gain computer once rather than once
+    per channel.
+*/
+enum class DetectorLink
+{
+    perChannel,
+    maximum,
+    sum
+};
+
+namespace DetectorLinking
+{
+    /** Writes the linked detector input for numSamples samples from start:
+        the rectified peak across channels for maximum, their mean rectified
+        level for sum, so a signal identical in every channel reads the same
+        either way.
+    */
+    template <typename Block, typename SampleType>
+    void getDetectorInput (const Block& block, size_t numChannels,
+                           size_t start, size_t numSamples, DetectorLink link, SampleType* destination) noexcept
+    {
+        std::fill(destination, destination + numSamples, SampleType());
+
+        for( size_t ch = 0; ch < numChannels; ++ch )
+        {
+            auto* src = block.getChannelPointer(ch) + start;
+
+            if( link == DetectorLink::maximum )
+            {
+                for( size_t i = 0; i < numSamples; ++i )
+                    destination[i] = juce::jmax(destination[i], std::abs(src[i]));
+            }
+            else
+            {
+                for( size_t i = 0; i < numSamples; ++i )
+                    destination[i] += std::abs(src[i]);
+            }
+        }
+
+        if( link == DetectorLink::sum && numChannels > 1 )
+        {
+            auto scale = static_cast<SampleType> (1.0) / static_cast<SampleType> (numChannels);
+
+            for( size_t i = 0; i < numSamples; ++i )
+                destination[i] *= scale;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/**
+    Branch-free log2/exp2 built from bit manipulation and short polynomials.
+
+    They only use arithmetic, compares and bit reinterpretation, so loops over
+    fixed-size lane arrays calling them are vectorised by the compiler (SSE,
+    AVX or NEON) instead of falling back to libm one lane at a time. Both are
+    accurate to roughly float precision, for float and double.
+*/
+namespace FastMath
+{
+    template <typename FloatType> struct FloatBits;
+    
+    template <> struct FloatBits<float>
+    {
+        using IntType = int32_t;
+        static constexpr int mantissaBits = 23;
+        static constexpr int exponentBias = 127;
+    };
+    
+    template <> struct FloatBits<double>
+    {
+        using IntType = int64_t;
+        static constexpr int mantissaBits = 52;
+        static constexpr int exponentBias = 1023;
+    };
+    
+    /** log2 of a positive, normal number. */
+    template <typename FloatType>
+    inline FloatType log2 (FloatType x) noexcept
+    {
+        using Bits = FloatBits<FloatType>;
+        using IntType = typename Bits::IntType;
+        constexpr auto mantissaMask = (IntType (1) << Bits::mantissaBits) - 1;
+        constexpr auto exponentOfOne = IntType (Bits::exponentBias) << Bits::mantissaBits;
+        
+        IntType bits;
+        std::memcpy (&bits, &x, sizeof (x));
+        
+        auto exponent = (FloatType) ((int32_t) (bits >> Bits::mantissaBits) - Bits::exponentBias);
+        
+        //mantissa in [1, 2), folded to [sqrt(1/2), sqrt(2)) to keep the series short
+        auto mantissaBits = (bits & mantissaMask) | exponentOfOne;
+        FloatType mantissa;
+        std::memcpy (&mantissa, &mantissaBits, sizeof (mantissa));
+        
+        auto fold = mantissa > (FloatType) 1.41421356237309515;
+        mantissa = fold ? mantissa * (FloatType) 0.5 : mantissa;
+        exponent = fold ? exponent + (FloatType) 1 : exponent;
+        
+        //ln(m) = 2 atanh((m - 1) / (m + 1))
+        auto y = (mantissa - (FloatType) 1) / (mantissa + (FloatType) 1);
+        auto y2 = y * y;
+        auto series = (FloatType) 1 + y2 * ((FloatType) (1.0 / 3.0)
+                                    + y2 * ((FloatType) (1.0 / 5.0)
+                                    + y2 * ((FloatType) (1.0 / 7.0)
+                                    + y2 * (FloatType) (1.0 / 9.0))));
+        
+        return exponent + y * series * (FloatType) (2.0 / 0.69314718055994531);
+    }
+    
+    /** 2^x, clamped to the normal range of FloatType. */
+    template <typename FloatType>
+    inline FloatType exp2 (FloatType x) noexcept
+    {
+        using Bits = FloatBits<FloatType>;
+        using IntType = typename Bits::IntType;
+        constexpr auto limit = (FloatType) (Bits::exponentBias - 1);
+        
+        x = x < -limit ? -limit : (x > limit ? limit : x);
+        
+        //adding 1.5 * 2^mantissaBits rounds x to the nearest integer and leaves
+        //that integer in the low mantissa bits, without a float to int conversion
+        constexpr auto roundingMagic = (FloatType) (3 * (IntType (1) << (Bits::mantissaBits - 1)));
+        auto shifted = x + roundingMagic;
+        auto f = x - (shifted - roundingMagic);
+        
+        IntType shiftedBits, magicBits;
+        std::memcpy (&shiftedBits, &shifted, sizeof (shifted));
+        std::memcpy (&magicBits, &roundingMagic, sizeof (roundingMagic));
+        auto whole = shiftedBits - magicBits;
+        
+        //Taylor series of e^(f ln2), good to ~1e-8 over the reduced range
+        auto p = (FloatType) 1 + f * ((FloatType) 6.931471805599453e-1
+                               + f * ((FloatType) 2.402265069591007e-1
+                               + f * ((FloatType) 5.550410866482158e-2
+                               + f * ((FloatType) 9.618129107628477e-3
+                               + f * ((FloatType) 1.333355814642844e-3
+                               + f * ((FloatType) 1.540353039338161e-4
+                               + f * (FloatType) 1.525273380405984e-5))))));
+        
+        auto scaleBits = (whole + Bits::exponentBias) << Bits::mantissaBits;
+        FloatType scale;
+        std::memcpy (&scale, &scaleBits, sizeof (scale));
+        
+        return p * scale;
+    }
+}
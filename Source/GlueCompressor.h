@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    GlueCompressor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "FastMath.h"
+#include "DetectorLink.h"
+
+//==============================================================================
+/**
+    The full-band glue compressor.
+
+    Per channel it is juce::dsp::Compressor: peak ballistics with the same
+    time constants and a hard-knee gain computer, with the pow evaluated as
+    exp2/log2 from FastMath like MultibandCompressor. With a linked detector
+    it runs one envelope on the channels' maximum or summed level and applies
+    the resulting gain to all of them.
+*/
+template <typename SampleType>
+class GlueCompressor
+{
+public:
+    static constexpr size_t tileSize = 32;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0);
+        jassert (spec.numChannels > 0);
+
+        sampleRate = spec.sampleRate;
+        numChannels = spec.numChannels;
+        envelope.assign(numChannels, SampleType());
+
+        update();
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(envelope.begin(), envelope.end(), SampleType());
+        linkedEnvelope = 0;
+    }
+
+    void setThreshold (SampleType newThresholdDecibels)    { thresholdDecibels = newThresholdDecibels; update(); }
+    void setRatio (SampleType newRatio)                    { jassert (newRatio >= 1); ratio = newRatio; update(); }
+    void setAttack (SampleType newAttackMs)                { attackTime = newAttackMs; update(); }
+    void setRelease (SampleType newReleaseMs)              { releaseTime = newReleaseMs; update(); }
+
+    /** Switching carries the detector over, as MultibandCompressor does. */
+    void setDetectorLink (DetectorLink newLink) noexcept
+    {
+        if( newLink == link )
+            return;
+
+        if( link == DetectorLink::perChannel && ! envelope.empty() )
+            linkedEnvelope = *std::max_element(envelope.begin(), envelope.end());
+        else if( newLink == DetectorLink::perChannel )
+            std::fill(envelope.begin(), envelope.end(), linkedEnvelope);
+
+        link = newLink;
+    }
+
+    DetectorLink getDetectorLink() const noexcept  { return link; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        auto&& inputBlock = context.getInputBlock();
+        auto&& outputBlock = context.getOutputBlock();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == outputBlock.getNumSamples());
+
+        if( context.isBypassed )
+        {
+            if( context.usesSeparateInputAndOutputBlocks() )
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        auto blockChannels = juce::jmin(outputBlock.getNumChannels(), numChannels);
+        auto numSamples = outputBlock.getNumSamples();
+
+        if( link != DetectorLink::perChannel )
+        {
+            processLinked(inputBlock, outputBlock, blockChannels, numSamples);
+            return;
+        }
+
+        for( size_t ch = 0; ch < blockChannels; ++ch )
+        {
+            auto* in = inputBlock.getChannelPointer(ch);
+            auto* out = outputBlock.getChannelPointer(ch);
+            auto env = envelope[ch];
+
+            for( size_t i = 0; i < numSamples; ++i )
+                out[i] = in[i] * computeGain(std::abs(in[i]), env);
+
+            envelope[ch] = env;
+        }
+    }
+
+private:
+    SampleType calculateBallisticsCoef (SampleType timeMs) const
+    {
+        //same time constant definition as juce::dsp::BallisticsFilter
+        return timeMs < static_cast<SampleType> (1.0e-3) ? 0
+                                                          : static_cast<SampleType> (std::exp (-2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate / timeMs));
+    }
+
+    void update()
+    {
+        thresholdLog2 = juce::jmax(thresholdDecibels, static_cast<SampleType> (-200.0)) * static_cast<SampleType> (0.16609640474436813);
+        slope = static_cast<SampleType> (1.0) / ratio - static_cast<SampleType> (1.0);
+        attackCoef = calculateBallisticsCoef(attackTime);
+        releaseCoef = calculateBallisticsCoef(releaseTime);
+    }
+
+    //peak ballistics, then (env / threshold)^(1/ratio - 1) above threshold
+    SampleType computeGain (SampleType rectified, SampleType& env) const noexcept
+    {
+        auto coef = rectified > env ? attackCoef : releaseCoef;
+        env = rectified + coef * (env - rectified);
+
+        auto overshoot = FastMath::log2(env + static_cast<SampleType> (1.0e-30)) - thresholdLog2;
+        return overshoot > 0 ? FastMath::exp2(overshoot * slope) : static_cast<SampleType> (1);
+    }
+
+    template <typename InputBlock, typename OutputBlock>
+    void processLinked (const InputBlock& inputBlock, OutputBlock& outputBlock,
+                        size_t blockChannels, size_t numSamples) noexcept
+    {
+        alignas (32) SampleType gain[tileSize];
+        auto env = linkedEnvelope;
+
+        for( size_t start = 0; start < numSamples; start += tileSize )
+        {
+            auto tileLength = juce::jmin(tileSize, numSamples - start);
+
+            DetectorLinking::getDetectorInput(inputBlock, blockChannels, start, tileLength, link, gain);
+
+            for( size_t i = 0; i < tileLength; ++i )
+                gain[i] = computeGain(gain[i], env);
+
+            for( size_t ch = 0; ch < blockChannels; ++ch )
+            {
+                auto* in = inputBlock.getChannelPointer(ch) + start;
+                auto* out = outputBlock.getChannelPointer(ch) + start;
+
+                for( size_t i = 0; i < tileLength; ++i )
+                    out[i] = in[i] * gain[i];
+            }
+        }
+
+        linkedEnvelope = env;
+    }
+
+    SampleType thresholdDecibels = 0, ratio = 1, attackTime = 1, releaseTime = 100;
+    SampleType thresholdLog2 = 0, slope = 0, attackCoef = 0, releaseCoef = 0;
+
+    std::vector<SampleType> envelope;
+    SampleType linkedEnvelope = 0;
+    DetectorLink link = DetectorLink::perChannel;
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 0;
+};
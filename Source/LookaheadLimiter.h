@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    LookaheadLimiter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <numeric>
+
+//==============================================================================
+/**
+    Brickwall peak limiter with a short lookahead.
+
+    The gain each sample needs (ceiling over its loudest channel) goes through
+    a sliding minimum over the lookahead window, kept as a monotonic deque so
+    it costs O(1) per sample however long the window is. Rises are then
+    slowed by the release, and a moving average over the same window turns
+    every fall into a straight ramp that is complete when the peak that
+    caused it comes out of the delay line. The output therefore never
+    exceeds the ceiling, and the gain has no steps.
+
+    All channels share one gain. Every buffer is allocated in prepare for the
+    longest lookahead, maxLookaheadSeconds, so neither process nor changing
+    the lookahead ever allocates.
+*/
+template <typename SampleType>
+class LookaheadLimiter
+{
+public:
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0);
+        jassert (spec.numChannels > 0);
+
+        sampleRate = spec.sampleRate;
+        numChannels = spec.numChannels;
+
+        maxWindowSize = getWindowSize(maxLookaheadSeconds);
+
+        delayLines.allocate(numChannels * maxWindowSize, true);
+        gainHistory.allocate(maxWindowSize, true);
+        dequeIndex.allocate(maxWindowSize, true);
+        dequeValue.allocate(maxWindowSize, true);
+
+        releaseCoef = static_cast<SampleType> (std::exp (-1.0 / (releaseSeconds * sampleRate)));
+
+        windowSize = getWindowSize(lookaheadSeconds);
+        lookahead = windowSize - 1;
+
+        reset();
+    }
+
+    void reset()
+    {
+        if( windowSize == 0 )
+            return;
+
+        std::fill(delayLines.get(), delayLines.get() + numChannels * windowSize, SampleType());
+        std::fill(gainHistory.get(), gainHistory.get() + windowSize, SampleType (1));
+
+        gainSum = (double) windowSize;
+        releasedGain = 1;
+        writePosition = 0;
+        sampleCount = 0;
+        dequeStart = dequeSize = 0;
+    }
+
+    void setCeilingDecibels (SampleType newCeilingDecibels) noexcept
+    {
+        ceiling = juce::Decibels::decibelsToGain(newCeilingDecibels, static_cast<SampleType> (-100.0));
+    }
+
+    /** Up to maxLookaheadSeconds. Once prepared, a lookahead that comes to a
+        different number of samples resets the limiter, as the delay line
+        changes length; getLatencySamples follows straight away.
+    */
+    void setLookaheadSeconds (double newLookaheadSeconds) noexcept
+    {
+        lookaheadSeconds = juce::jlimit(0.0, maxLookaheadSeconds, newLookaheadSeconds);
+
+        if( maxWindowSize == 0 )
+            return;
+
+        auto newWindowSize = getWindowSize(lookaheadSeconds);
+
+        if( newWindowSize == windowSize )
+            return;
+
+        windowSize = newWindowSize;
+        lookahead = windowSize - 1;
+        reset();
+    }
+
+    double getLookaheadSeconds() const noexcept { return lookaheadSeconds; }
+
+    /** Samples the output lags the input by. */
+    int getLatencySamples() const noexcept  { return (int) lookahead; }
+
+    static constexpr double maxLookaheadSeconds = 0.005;
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        auto&& inputBlock = context.getInputBlock();
+        auto&& outputBlock = context.getOutputBlock();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == outputBlock.getNumSamples());
+
+        if( context.isBypassed )
+        {
+            if( context.usesSeparateInputAndOutputBlocks() )
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        auto blockChannels = juce::jmin(outputBlock.getNumChannels(), numChannels);
+        auto numSamples = outputBlock.getNumSamples();
+
+        for( size_t i = 0; i < numSamples; ++i )
+        {
+            SampleType peak = 0;
+
+            for( size_t ch = 0; ch < blockChannels; ++ch )
+                peak = juce::jmax(peak, std::abs(inputBlock.getSample((int) ch, (int) i)));
+
+            auto required = peak > ceiling ? ceiling / peak : static_cast<SampleType> (1);
+            auto held = pushAndGetMinimum(required);
+
+            //falls land at once, the average below turns them into ramps
+            releasedGain = held < releasedGain ? held : held + releaseCoef * (releasedGain - held);
+
+            gainSum += (double) releasedGain - (double) gainHistory[writePosition];
+            gainHistory[writePosition] = releasedGain;
+            auto gain = static_cast<SampleType> (gainSum / (double) windowSize);
+
+            //the oldest sample in the delay line is the one leaving it now
+            auto readPosition = writePosition + 1 == windowSize ? 0 : writePosition + 1;
+
+            for( size_t ch = 0; ch < blockChannels; ++ch )
+            {
+                auto* line = delayLines.get() + ch * windowSize;
+                line[writePosition] = inputBlock.getSample((int) ch, (int) i);
+                outputBlock.setSample((int) ch, (int) i, line[readPosition] * gain);
+            }
+
+            writePosition = readPosition;
+            ++sampleCount;
+
+            //keeps the running sum from drifting, at the same samples however
+            //the input is split into blocks
+            if( writePosition == 0 )
+                gainSum = std::accumulate(gainHistory.get(), gainHistory.get() + windowSize, 0.0);
+        }
+    }
+
+private:
+    //the window covers the delay and the sample being written
+    size_t getWindowSize (double seconds) const noexcept
+    {
+        return (size_t) juce::jmax(1, juce::roundToInt(seconds * sampleRate)) + 1;
+    }
+
+    //sliding minimum of the last windowSize values: values that can never be
+    //the minimum again are dropped from the back, expired ones from the front
+    SampleType pushAndGetMinimum (SampleType value) noexcept
+    {
+        //expiring first keeps the deque within windowSize entries
+        if( dequeSize > 0 && dequeIndex[dequeStart] + windowSize <= sampleCount )
+        {
+            dequeStart = (dequeStart + 1) % windowSize;
+            --dequeSize;
+        }
+
+        while( dequeSize > 0 && dequeValue[(dequeStart + dequeSize - 1) % windowSize] >= value )
+            --dequeSize;
+
+        auto back = (dequeStart + dequeSize) % windowSize;
+        dequeValue[back] = value;
+        dequeIndex[back] = sampleCount;
+        ++dequeSize;
+
+        return dequeValue[dequeStart];
+    }
+
+    static constexpr double releaseSeconds = 0.06;
+
+    double sampleRate = 44100.0, lookaheadSeconds = 0.0015;
+    size_t numChannels = 0, lookahead = 0, windowSize = 0, maxWindowSize = 0;
+
+    SampleType ceiling = 1, releaseCoef = 0, releasedGain = 1;
+    double gainSum = 0;
+
+    juce::HeapBlock<SampleType> delayLines, gainHistory, dequeValue;
+    juce::HeapBlock<juce::uint64> dequeIndex;
+    size_t writePosition = 0, dequeStart = 0, dequeSize = 0;
+    juce::uint64 sampleCount = 0;
+};
@@ -0,0 +1,351 @@
+/*
+  ==============================================================================
+
+    MultibandCompressor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "FastMath.h"
+#include "DetectorLink.h"
+
+//==============================================================================
+/**
+    Fused compressor for the three crossover bands.
+
+    Every band/channel pair is one lane, and lanes are processed laneWidth at a
+    time, so stereo (3 bands x 2 channels) fits a single lane group. Input gain,
+    peak ballistics, the gain computer and output gain all happen in one pass
+    over fixed-size lane arrays, which the compiler turns into SSE/AVX/NEON
+    code. The ballistics and gain computer follow juce::dsp::Compressor, with
+    the pow evaluated as exp2/log2 from FastMath.
+
+    With a linked detector, each band instead runs a single envelope on the
+    maximum or summed level of its channels and applies that one gain to
+    all of them, so a multichannel bed keeps its image while the bands pump.
+*/
+template <typename SampleType>
+class MultibandCompressor
+{
+public:
+    enum
+    {
+        lowBand,
+        midBand,
+        highBand,
+        numBands
+    };
+    
+    static constexpr size_t laneWidth = 8;
+    static constexpr size_t tileSize = 32;
+    
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0);
+        jassert (spec.numChannels > 0);
+        
+        sampleRate = spec.sampleRate;
+        numChannels = spec.numChannels;
+        
+        auto numLanes = numBands * numChannels;
+        numGroups = (numLanes + laneWidth - 1) / laneWidth;
+        
+        for( auto* lanes : { &inputGain, &outputGain, &thresholdLog2, &slope, &attackCoef, &releaseCoef, &envelope } )
+        {
+            lanes->assign(numGroups * laneWidth, SampleType());
+        }
+        
+        for( size_t band = 0; band < numBands; ++band )
+        {
+            updateBand(band);
+        }
+        
+        reset();
+    }
+    
+    void reset()
+    {
+        std::fill(envelope.begin(), envelope.end(), SampleType());
+        std::fill(linkedEnvelope.begin(), linkedEnvelope.end(), SampleType());
+    }
+    
+    /** Switching carries the detectors over: a linked band starts from its
+        loudest channel's envelope, unlinked channels from the shared one.
+    */
+    void setDetectorLink (DetectorLink newLink) noexcept
+    {
+        if( newLink == link )
+            return;
+        
+        auto wasLinked = link != DetectorLink::perChannel;
+        link = newLink;
+        
+        if( wasLinked == (link != DetectorLink::perChannel) )
+            return;
+        
+        for( size_t band = 0; band < numBands; ++band )
+        {
+            auto* lanes = envelope.data() + band * numChannels;
+            
+            if( ! wasLinked )
+                linkedEnvelope[band] = numChannels > 0 ? *std::max_element(lanes, lanes + numChannels) : SampleType();
+            else
+                std::fill(lanes, lanes + numChannels, linkedEnvelope[band]);
+        }
+    }
+    
+    DetectorLink getDetectorLink() const noexcept  { return link; }
+    
+    void setThreshold (size_t band, SampleType newThresholdDecibels)   { bands[band].threshold = newThresholdDecibels; updateBand(band); }
+    void setRatio (size_t band, SampleType newRatio)                   { jassert (newRatio >= 1); bands[band].ratio = newRatio; updateBand(band); }
+    void setAttack (size_t band, SampleType newAttackMs)               { bands[band].attack = newAttackMs; updateBand(band); }
+    void setRelease (size_t band, SampleType newReleaseMs)             { bands[band].release = newReleaseMs; updateBand(band); }
+    void setInputGainDecibels (size_t band, SampleType newGainDb)      { bands[band].inputGain = newGainDb; updateBand(band); }
+    void setOutputGainDecibels (size_t band, SampleType newGainDb)     { bands[band].outputGain = newGainDb; updateBand(band); }
+    
+    /** Sets each lane's envelope to the peak of the start of its band block,
+        as if the detector had already settled on it. Used when the bands
+        resume after being skipped, so they don't start out uncompressed.
+        Only the first seedSamples count, so the result doesn't depend on how
+        the caller splits its blocks.
+    */
+    static constexpr size_t seedSamples = 64;
+    
+    void seedEnvelopes (const std::array<juce::dsp::AudioBlock<SampleType>, numBands>& bandBlocks) noexcept
+    {
+        auto blockChannels = juce::jmin(bandBlocks[0].getNumChannels(), numChannels);
+        auto numSamples = (int) juce::jmin(bandBlocks[0].getNumSamples(), seedSamples);
+        
+        for( size_t band = 0; band < numBands; ++band )
+        {
+            for( size_t ch = 0; ch < blockChannels; ++ch )
+            {
+                auto lane = band * numChannels + ch;
+                auto range = juce::FloatVectorOperations::findMinAndMax(bandBlocks[band].getChannelPointer(ch), numSamples);
+                envelope[lane] = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd())) * inputGain[lane];
+            }
+            
+            auto* lanes = envelope.data() + band * numChannels;
+            linkedEnvelope[band] = blockChannels > 0 ? *std::max_element(lanes, lanes + blockChannels) : SampleType();
+        }
+    }
+    
+    /** Compresses each band block in place. */
+    void process (std::array<juce::dsp::AudioBlock<SampleType>, numBands>& bandBlocks) noexcept
+    {
+        processBands(bandBlocks, 0, numBands);
+    }
+    
+    /** Compresses only bands firstBand to firstBand + numBandsToProcess - 1.
+        No state is shared between bands, so separate ranges can be processed
+        on separate threads at the same time.
+    */
+    void processBands (std::array<juce::dsp::AudioBlock<SampleType>, numBands>& bandBlocks,
+                       size_t firstBand, size_t numBandsToProcess) noexcept
+    {
+        auto blockChannels = juce::jmin(bandBlocks[0].getNumChannels(), numChannels);
+        auto numSamples = bandBlocks[0].getNumSamples();
+        auto endBand = juce::jmin((size_t) numBands, firstBand + numBandsToProcess);
+        
+        if( link != DetectorLink::perChannel )
+        {
+            processLinked(bandBlocks, firstBand, endBand, blockChannels, numSamples);
+            return;
+        }
+        
+        auto endLane = endBand * numChannels;
+        
+        for( auto firstLane = firstBand * numChannels; firstLane < endLane; firstLane += laneWidth )
+        {
+            std::array<SampleType*, laneWidth> lanePointers {};
+            auto numLanes = juce::jmin(laneWidth, endLane - firstLane);
+            
+            for( size_t lane = 0; lane < numLanes; ++lane )
+            {
+                auto band = (firstLane + lane) / numChannels;
+                auto ch = (firstLane + lane) % numChannels;
+                
+                //channels the block doesn't have are left as silent lanes
+                if( ch < blockChannels )
+                    lanePointers[lane] = bandBlocks[band].getChannelPointer(ch);
+            }
+            
+            processGroup(firstLane, lanePointers, numLanes, numSamples);
+        }
+    }
+    
+private:
+    struct BandParameters
+    {
+        SampleType threshold = 0, ratio = 1, attack = 1, release = 100, inputGain = 0, outputGain = 0;
+    };
+    
+    SampleType calculateBallisticsCoef (SampleType timeMs) const
+    {
+        //same time constant definition as juce::dsp::BallisticsFilter
+        return timeMs < static_cast<SampleType> (1.0e-3) ? 0
+                                                          : static_cast<SampleType> (std::exp (-2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate / timeMs));
+    }
+    
+    void updateBand (size_t band)
+    {
+        if( numChannels == 0 )
+            return;
+        
+        const auto& p = bands[band];
+        
+        for( size_t ch = 0; ch < numChannels; ++ch )
+        {
+            auto lane = band * numChannels + ch;
+            inputGain[lane] = juce::Decibels::decibelsToGain(p.inputGain);
+            outputGain[lane] = juce::Decibels::decibelsToGain(p.outputGain);
+            thresholdLog2[lane] = juce::jmax(p.threshold, static_cast<SampleType> (-200.0)) * static_cast<SampleType> (0.16609640474436813);
+            slope[lane] = static_cast<SampleType> (1.0) / p.ratio - static_cast<SampleType> (1.0);
+            attackCoef[lane] = calculateBallisticsCoef(p.attack);
+            releaseCoef[lane] = calculateBallisticsCoef(p.release);
+        }
+    }
+    
+    //only the numLanes lanes from firstLane are read or written, so groups
+    //that don't overlap can run concurrently; the rest of the group is silent
+    void processGroup (size_t firstLane, const std::array<SampleType*, laneWidth>& lanePointers,
+                       size_t numLanes, size_t numSamples) noexcept
+    {
+        alignas (32) SampleType inGain[laneWidth] = {}, outGain[laneWidth] = {}, thresh[laneWidth] = {}, slp[laneWidth] = {};
+        alignas (32) SampleType attack[laneWidth] = {}, release[laneWidth] = {}, env[laneWidth] = {};
+        
+        for( size_t lane = 0; lane < numLanes; ++lane )
+        {
+            inGain[lane] = inputGain[firstLane + lane];
+            outGain[lane] = outputGain[firstLane + lane];
+            thresh[lane] = thresholdLog2[firstLane + lane];
+            slp[lane] = slope[firstLane + lane];
+            attack[lane] = attackCoef[firstLane + lane];
+            release[lane] = releaseCoef[firstLane + lane];
+            env[lane] = envelope[firstLane + lane];
+        }
+        
+        //lanes are transposed into a small sample-major tile so the maths below
+        //runs on whole registers, one sample of every lane at a time
+        alignas (32) SampleType tile[tileSize][laneWidth] = {};
+        
+        for( size_t start = 0; start < numSamples; start += tileSize )
+        {
+            auto tileLength = juce::jmin(tileSize, numSamples - start);
+            
+            for( size_t lane = 0; lane < numLanes; ++lane )
+            {
+                if( lanePointers[lane] == nullptr )
+                    continue;
+                
+                auto* src = lanePointers[lane] + start;
+                for( size_t i = 0; i < tileLength; ++i )
+                    tile[i][lane] = src[i];
+            }
+            
+            for( size_t i = 0; i < tileLength; ++i )
+            {
+                auto* x = tile[i];
+                
+                for( size_t lane = 0; lane < laneWidth; ++lane )
+                {
+                    auto in = x[lane] * inGain[lane];
+                    
+                    //peak ballistics
+                    auto rectified = std::abs(in);
+                    auto coef = rectified > env[lane] ? attack[lane] : release[lane];
+                    env[lane] = rectified + coef * (env[lane] - rectified);
+                    
+                    //gain computer: (env / threshold)^(1/ratio - 1) above threshold, with
+                    //the floor on env added rather than selected so the loop stays branch-free
+                    auto overshoot = FastMath::log2(env[lane] + static_cast<SampleType> (1.0e-30)) - thresh[lane];
+                    auto gainLog2 = overshoot > 0 ? overshoot * slp[lane] : static_cast<SampleType> (0);
+                    
+                    x[lane] = in * FastMath::exp2(gainLog2) * outGain[lane];
+                }
+            }
+            
+            for( size_t lane = 0; lane < numLanes; ++lane )
+            {
+                if( lanePointers[lane] == nullptr )
+                    continue;
+                
+                auto* dst = lanePointers[lane] + start;
+                for( size_t i = 0; i < tileLength; ++i )
+                    dst[i] = tile[i][lane];
+            }
+        }
+        
+        for( size_t lane = 0; lane < numLanes; ++lane )
+            envelope[firstLane + lane] = env[lane];
+    }
+    
+    void processLinked (std::array<juce::dsp::AudioBlock<SampleType>, numBands>& bandBlocks,
+                        size_t firstBand, size_t endBand, size_t blockChannels, size_t numSamples) noexcept
+    {
+        //every channel of a band has the same settings, so the first lane's stand for the band.
+        //Only this call's bands are touched: parallel calls own the others'
+        //envelopes and may be writing them meanwhile
+        alignas (32) SampleType inGain[numBands], outGain[numBands], thresh[numBands], slp[numBands];
+        alignas (32) SampleType attack[numBands], release[numBands], env[numBands];
+        
+        for( size_t band = firstBand; band < endBand; ++band )
+        {
+            auto lane = band * numChannels;
+            inGain[band] = inputGain[lane];
+            outGain[band] = outputGain[lane];
+            thresh[band] = thresholdLog2[lane];
+            slp[band] = slope[lane];
+            attack[band] = attackCoef[lane];
+            release[band] = releaseCoef[lane];
+            env[band] = linkedEnvelope[band];
+        }
+        
+        alignas (32) SampleType detector[numBands][tileSize];
+        
+        for( size_t start = 0; start < numSamples; start += tileSize )
+        {
+            auto tileLength = juce::jmin(tileSize, numSamples - start);
+            
+            //level across the channels, then one detector and one gain per band
+            for( size_t band = firstBand; band < endBand; ++band )
+            {
+                auto* peak = detector[band];
+                DetectorLinking::getDetectorInput(bandBlocks[band], blockChannels, start, tileLength, link, peak);
+                
+                for( size_t i = 0; i < tileLength; ++i )
+                {
+                    auto rectified = peak[i] * inGain[band];
+                    auto coef = rectified > env[band] ? attack[band] : release[band];
+                    env[band] = rectified + coef * (env[band] - rectified);
+                    
+                    auto overshoot = FastMath::log2(env[band] + static_cast<SampleType> (1.0e-30)) - thresh[band];
+                    auto gainLog2 = overshoot > 0 ? overshoot * slp[band] : static_cast<SampleType> (0);
+                    
+                    peak[i] = inGain[band] * FastMath::exp2(gainLog2) * outGain[band];
+                }
+                
+                for( size_t ch = 0; ch < blockChannels; ++ch )
+                {
+                    auto* dst = bandBlocks[band].getChannelPointer(ch) + start;
+                    for( size_t i = 0; i < tileLength; ++i )
+                        dst[i] *= peak[i];
+                }
+            }
+        }
+        
+        for( size_t band = firstBand; band < endBand; ++band )
+            linkedEnvelope[band] = env[band];
+    }
+    
+    std::array<BandParameters, numBands> bands;
+    std::vector<SampleType> inputGain, outputGain, thresholdLog2, slope, attackCoef, releaseCoef, envelope;
+    std::array<SampleType, numBands> linkedEnvelope {};
+    DetectorLink link = DetectorLink::perChannel;
+    
+    double sampleRate = 44100.0;
+    size_t numChannels = 0, numGroups = 0;
+};
@@ -9,14 +9,103 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+void BackgroundCache::setSource (const juce::Image& image)
+{
+    source = image;
+    rendered = {};
+}
+
+void BackgroundCache::draw (juce::Graphics& g, juce::Rectangle<int> area)
+{
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    auto width = juce::jmax (1, juce::roundToInt ((float) area.getWidth() * scale));
+    auto height = juce::jmax (1, juce::roundToInt ((float) area.getHeight() * scale));
+
+    if (! rendered.isValid() || scale != renderedScale
+          || rendered.getWidth() != width || rendered.getHeight() != height)
+    {
+        rendered = juce::Image (juce::Image::RGB, width, height, false);
+        renderedScale = scale;
+
+        juce::Graphics rg (rendered);
+        rg.addTransform (juce::AffineTransform::scale (scale));
+        rg.fillAll (fill);
+        rg.drawImageAt (source, 0, 0);
+    }
+
+    //one image pixel per physical pixel, so this is a plain copy
+    g.drawImageTransformed (rendered, juce::AffineTransform::scale (1.0f / scale)
+                                          .translated ((float) area.getX(), (float) area.getY()));
+}
+
+//==============================================================================
 myAnalyzer::myAnalyzer(CompressorPieceAudioProcessor& p)
-                        : audioProcessor (p), fftOut(fftOrder),
-                          windowOut(fftSize, juce::dsp::WindowingFunction<float>::hann),
-                          fftIn(fftOrder),
-                          windowIn(fftSize, juce::dsp::WindowingFunction<float>::hann)
+                        : juce::Thread ("Spectrum analyzer"),
+                          audioProcessor (p),
+                          spectrum (SpectrumResources::get (*sharedResources, fftOrder))
+{
+    setOpaque (true);
+}
+
+myAnalyzer::~myAnalyzer()
+{
+    stopAnalysis();
+}
+
+void myAnalyzer::startAnalysis()
+{
+    if (analysing)
+        return;
+
+    analysing = true;
+    idleFrames = 0;
+    timerSleeping = false;
+
+    audioProcessor.analyzerTap.setActive (true);
+    startThread();
+    startTimerHz (frameRate);
+}
+
+void myAnalyzer::stopAnalysis()
+{
+    if (! analysing)
+        return;
+
+    analysing = false;
+
+    stopTimer();
+    stopThread (1000);
+    cancelPendingUpdate();
+    audioProcessor.analyzerTap.setActive (false);
+}
+
+void myAnalyzer::updateAnalysis()
+{
+    if (isShowing())
+        startAnalysis();
+    else
+        stopAnalysis();
+}
+
+void myAnalyzer::visibilityChanged()
+{
+    updateAnalysis();
+}
+
+void myAnalyzer::parentHierarchyChanged()
 {
-    setAudioChannels (2, 0);
-    startTimerHz (30);
+    updateAnalysis();
+}
+
+void myAnalyzer::setBackground (const juce::Image& image)
+{
+    background.setSource (image);
+    repaint();
+}
+
+void myAnalyzer::resized()
+{
+    scopeHeight = getHeight();
 }
 
 void myAnalyzer::pushNextSampleIntoFifo (float sample, int i) noexcept
@@ -53,34 +142,35 @@ void myAnalyzer::pushNextSampleIntoFifo (float sample, int i) noexcept
     }
 }
 
-void myAnalyzer::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+void myAnalyzer::drainTap()
 {
-    if (audioProcessor.inBuff.buffer->getNumChannels() > 0)
-    {
-        auto* channelData = audioProcessor.inBuff.buffer->getReadPointer (0, audioProcessor.inBuff.startSample);
+    float pre[512], post[512];
 
-        for (auto i = 0; i < audioProcessor.inBuff.numSamples; ++i)
-            pushNextSampleIntoFifo (channelData[i], 0);
-    }
-    if(audioProcessor.outBuff.buffer->getNumChannels() > 0)
+    for (auto numRead = audioProcessor.analyzerTap.pull (pre, post, 512); numRead > 0;
+              numRead = audioProcessor.analyzerTap.pull (pre, post, 512))
     {
-        auto* channelData = audioProcessor.outBuff.buffer->getReadPointer (0, audioProcessor.outBuff.startSample);
-
-        for (auto i = 0; i < audioProcessor.outBuff.numSamples; ++i)
-            pushNextSampleIntoFifo (channelData[i], 1);
+        for (auto i = 0; i < numRead; ++i)
+        {
+            pushNextSampleIntoFifo (pre[i], 0);
+            pushNextSampleIntoFifo (post[i], 1);
+        }
     }
 }
 
 void myAnalyzer::drawNextFrameOfSpectrum()
 {
-    windowIn.multiplyWithWindowingTable (fftDataIn, fftSize);
-    windowOut.multiplyWithWindowingTable (fftDataOut, fftSize);
+    spectrum->multiplyWithWindow (fftDataIn);
+    spectrum->multiplyWithWindow (fftDataOut);
 
-    fftIn.performFrequencyOnlyForwardTransform (fftDataIn);
-    fftOut.performFrequencyOnlyForwardTransform (fftDataOut);
+    spectrum->fft.performFrequencyOnlyForwardTransform (fftDataIn);
+    spectrum->fft.performFrequencyOnlyForwardTransform (fftDataOut);
 
     auto mindB = -100.0f;
     auto maxdB =    0.0f;
+    auto height = (float) scopeHeight.load();
+
+    nextPathIn.clear();
+    nextPathOut.clear();
 
     for (int i = 0; i < scopeSize; ++i)
     {
@@ -94,73 +184,174 @@ void myAnalyzer::drawNextFrameOfSpectrum()
                                  mindB, maxdB, 0.0f, 1.0f);
         scopeDataIn[i] = levelIn;
         scopeDataOut[i] = levelOut;
+
+        auto x = (float) juce::jmap (i, 0, scopeSize - 1, 65, 380);
+        auto yIn = juce::jmap (levelIn, 0.0f, 1.0f, height, 162.0f);
+        auto yOut = juce::jmap (levelOut, 0.0f, 1.0f, height, 162.0f);
+
+        if (i == 0)
+        {
+            nextPathIn.startNewSubPath (x, yIn);
+            nextPathOut.startNewSubPath (x, yOut);
+        }
+        else
+        {
+            nextPathIn.lineTo (x, yIn);
+            nextPathOut.lineTo (x, yOut);
+        }
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock (pathLock);
+        pathIn.swapWithPath (nextPathIn);
+        pathOut.swapWithPath (nextPathOut);
+    }
+
+    newFrameReady = true;
+
+    if (timerSleeping.exchange (false))
+        triggerAsyncUpdate();
+}
+
+void myAnalyzer::run()
+{
+    while (! threadShouldExit())
+    {
+        drainTap();
+
+        if (nextReadyIn || nextReadyOut)
+        {
+            drawNextFrameOfSpectrum();
+            nextReadyIn = false;
+            nextReadyOut = false;
+        }
+
+        wait (1000 / 60);
     }
 }
 
 void myAnalyzer::timerCallback()
 {
-    if (nextReadyIn)
+    if (newFrameReady.exchange (false))
     {
-        drawNextFrameOfSpectrum();
-        nextReadyIn = false;
+        idleFrames = 0;
         repaint();
     }
-    if(nextReadyOut)
+    else if (++idleFrames >= idleFramesBeforeSleep)
     {
-        drawNextFrameOfSpectrum();
-        nextReadyOut = false;
-        repaint();
+        stopTimer();
+        timerSleeping = true;
+
+        //a frame published between the check above and now would not wake us
+        if (newFrameReady && timerSleeping.exchange (false))
+            handleAsyncUpdate();
     }
 }
 
+void myAnalyzer::handleAsyncUpdate()
+{
+    if (! analysing)
+        return;
+
+    idleFrames = 0;
+    startTimerHz (frameRate);
+}
+
 void myAnalyzer::drawFrame(juce::Graphics &g)
 {
-    for (int i = 1; i < scopeSize; ++i)
+    background.draw (g, getLocalBounds());
+
     {
-        auto width  = 380;
-        auto height = getLocalBounds().getHeight();
-
-        g.setColour(mycolors.mypink);
-        auto startX = (float) juce::jmap (i - 1, 0, scopeSize - 1, 65, width);
-        auto startY = juce::jmap (scopeDataIn[i - 1], 0.0f, 1.0f, (float) height, 162.0f);
-        auto endX = (float) juce::jmap (i,     0, scopeSize - 1, 65, width);
-        auto endY = juce::jmap (scopeDataIn[i],     0.0f, 1.0f, (float) height, 162.0f);
-        if(startX <= width && startY <= height && endX <= width && endY <= height
-           && startX >= 65.0f && startY >= 162.0f && endX >= 65.0f && endY >= 162.0f)
-        {
-            g.drawLine ({ startX, startY, endX, endY });
-        }
-        
-        g.setColour(mycolors.mylightPink);
-        startX = (float) juce::jmap (i - 1, 0, scopeSize - 1, 65, width);
-        startY = juce::jmap (scopeDataOut[i - 1], 0.0f, 1.0f, (float) height, 162.0f);
-        endX = (float) juce::jmap (i,     0, scopeSize - 1, 65, width);
-        endY = juce::jmap (scopeDataOut[i],     0.0f, 1.0f, (float) height, 162.0f);
-        if(startX <= width && startY <= height && endX <= width && endY <= height
-           && startX >= 65.0f && startY >= 162.0f && endX >= 65.0f && endY >= 162.0f)
-        {
-            g.drawLine ({ startX, startY, endX, endY });
-        }
-        
-        g.setColour(mycolors.mybrown);
-        float thresh = juce::jmap(pow(10.0f, ((float)audioProcessor.threshold->get())/20.0f), 0.0f, 1.0f, (float)height, 162.0f);
-        if(thresh < 162.0f){
-            thresh = 162.0f;
-        }
-        g.drawLine((float)65, thresh, (float)380, thresh);
+        const juce::SpinLock::ScopedLockType lock (pathLock);
+
+        g.setColour (mycolors.mypink);
+        g.strokePath (pathIn, juce::PathStrokeType (1.0f));
+
+        g.setColour (mycolors.mylightPink);
+        g.strokePath (pathOut, juce::PathStrokeType (1.0f));
+    }
+
+    auto height = getLocalBounds().getHeight();
+
+    g.setColour(mycolors.mybrown);
+    float thresh = juce::jmap(pow(10.0f, ((float)audioProcessor.threshold->get())/20.0f), 0.0f, 1.0f, (float)height, 162.0f);
+    if(thresh < 162.0f){
+        thresh = 162.0f;
     }
+    g.drawLine((float)65, thresh, (float)380, thresh);
+}
+
+#if POP_PRINCESS_TELEMETRY
+TelemetryView::TelemetryView(Telemetry& t)
+                        : telemetry (t)
+{
+    startTimerHz (4);
+}
+
+void TelemetryView::timerCallback()
+{
+    repaint();
 }
 
+void TelemetryView::paint (juce::Graphics& g)
+{
+    g.setColour (mycolors.mybrown);
+    g.setFont (11.0f);
+
+    auto percent = [] (float fraction) { return juce::String (fraction * 100.0f, 1) + "%"; };
+    auto row = getLocalBounds().reduced (10, 2).removeFromTop (11);
+
+    g.drawText ("stage", row.removeFromLeft (110), juce::Justification::left);
+    g.drawText ("p50", row.removeFromLeft (60), juce::Justification::right);
+    g.drawText ("p99", row.removeFromLeft (60), juce::Justification::right);
+    g.drawText ("max", row.removeFromLeft (60), juce::Justification::right);
+    g.drawText (status.isNotEmpty() ? status : juce::String ("quality: ") + QualityGovernor::getTierName (telemetry.getQualityTier())
+                                                   + ", opened in " + juce::String (editorOpenMs, 1) + " ms",
+                row, juce::Justification::right);
+
+    for (int stage = 0; stage < Telemetry::numStages; ++stage)
+    {
+        auto stats = telemetry.getStats ((Telemetry::Stage) stage);
+        row = getLocalBounds().reduced (10, 2).withTrimmedTop ((stage + 1) * 11).removeFromTop (11);
+
+        g.drawText (Telemetry::getStageName (stage), row.removeFromLeft (110), juce::Justification::left);
+        g.drawText (percent (stats.p50), row.removeFromLeft (60), juce::Justification::right);
+        g.drawText (percent (stats.p99), row.removeFromLeft (60), juce::Justification::right);
+        g.drawText (percent (stats.max), row.removeFromLeft (60), juce::Justification::right);
+    }
+}
+
+void TelemetryView::mouseDoubleClick (const juce::MouseEvent&)
+{
+    auto file = juce::File::getSpecialLocation (juce::File::userDesktopDirectory)
+                    .getNonexistentChildFile ("PopPrincessTrace", ".json");
+    auto result = telemetry.writeChromeTrace (file);
+
+    status = result.wasOk() ? "wrote " + file.getFileName() : result.getErrorMessage();
+    repaint();
+}
+#endif
+
 //==============================================================================
 CompressorPieceAudioProcessorEditor::CompressorPieceAudioProcessorEditor (CompressorPieceAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
+    sharedBackground = sharedResources->get<juce::Image>(0.0, 0, []
+    {
+        return std::make_shared<juce::Image>(juce::ImageCache::getFromMemory(BinaryData::makeup0_75x_png, BinaryData::makeup0_75x_pngSize));
+    });
+    background = *sharedBackground;
+    renderedBackground.setSource(background);
+
     setSize (450, 750);
 
     addAndMakeVisible(analyzer);
     addAndMakeVisible(&masterDial);
     addAndMakeVisible(&threshDial);
     addAndMakeVisible(&makeupDial);
+   #if POP_PRINCESS_TELEMETRY
+    addAndMakeVisible(telemetryView);
+   #endif
     
     masterAttach = std::make_unique<Attachment>(audioProcessor.apvts,"Amount",masterDial);
     jassert(masterAttach != nullptr);
@@ -169,6 +360,10 @@ CompressorPieceAudioProcessorEditor::CompressorPieceAudioProcessorEditor (Compre
     makeupAttach = std::make_unique<Attachment>(audioProcessor.apvts,"Makeup",makeupDial);
     jassert(makeupAttach != nullptr);
     
+    //the attachment moves the dial for host changes too, so this keeps the
+    //threshold line current even while the analyzer's timer sleeps
+    threshDial.onValueChange = [this] { analyzer.repaint(); };
+    
     masterDial.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     masterDial.setTextBoxStyle(juce::Slider::TextBoxBelow,false, 90, 0);
     masterDial.setTextValueSuffix(" %");
@@ -189,6 +384,15 @@ CompressorPieceAudioProcessorEditor::CompressorPieceAudioProcessorEditor (Compre
     makeupDial.setColour(juce::Slider::ColourIds::rotarySliderFillColourId, mycolors.mydarkPink);
     makeupDial.setColour(juce::Slider::ColourIds::rotarySliderOutlineColourId, mycolors.mymedPink);
     makeupDial.setColour(juce::Slider::ColourIds::thumbColourId, mycolors.mybrown);
+
+    constructionMs = juce::Time::getMillisecondCounterHiRes() - constructionStart;
+
+    if (constructionMs > constructionBudgetMs)
+        DBG ("Editor took " << constructionMs << " ms to construct, over the " << constructionBudgetMs << " ms budget");
+
+   #if POP_PRINCESS_TELEMETRY
+    telemetryView.setEditorOpenTime(constructionMs);
+   #endif
 }
 
 CompressorPieceAudioProcessorEditor::~CompressorPieceAudioProcessorEditor()
@@ -198,17 +402,19 @@ CompressorPieceAudioProcessorEditor::~CompressorPieceAudioProcessorEditor()
 //==============================================================================
 void CompressorPieceAudioProcessorEditor::paint (juce::Graphics& g)
 {
-    g.fillAll(mycolors.mylightPink);
-    juce::Image background = juce::ImageCache::getFromMemory(BinaryData::makeup0_75x_png, BinaryData::makeup0_75x_pngSize);
-    g.drawImageAt(background, 0, 0);
+    renderedBackground.draw(g, getLocalBounds());
 }
 
 void CompressorPieceAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
     analyzer.setBounds(bounds.removeFromTop(295));
+    analyzer.setBackground(background.getClippedImage(analyzer.getBounds()));
     
     masterDial.setBounds(125, 540, 200, 125);
     threshDial.setBounds(90, 370, 100, 120);
     makeupDial.setBounds(265, 370, 100, 120);
+   #if POP_PRINCESS_TELEMETRY
+    telemetryView.setBounds(getLocalBounds().removeFromBottom(93));
+   #endif
 }
@@ -27,22 +27,40 @@ enum
     scopeSize = 512
 };
 
-class myAnalyzer   : public juce::AudioAppComponent,
-                            private juce::Timer
+//a background image over a fill colour, rasterised once at the display's
+//pixel scale so every paint is a straight copy; redone only when the scale
+//or size changes
+class BackgroundCache
 {
 public:
-    myAnalyzer(CompressorPieceAudioProcessor&);
+    BackgroundCache (juce::Colour fillColour) : fill (fillColour) {}
 
-    ~myAnalyzer() override
-    {
-        shutdownAudio();
-    }
+    void setSource (const juce::Image&);
+    void draw (juce::Graphics&, juce::Rectangle<int> area);
 
-    //==============================================================================
-    void prepareToPlay (int, double) override {}
-    void releaseResources() override          {}
+private:
+    juce::Colour fill;
+    juce::Image source, rendered;
+    float renderedScale = 0.0f;
+};
+
+//the FFTs, windowing and dB mapping run on the analyzer's own thread, which
+//publishes finished paths; the message thread only strokes them. Nothing
+//runs unless the analyzer is showing: visibility, parent and peer changes
+//(which include minimising its window) start or stop the thread and the tap,
+//and the repaint timer sleeps whenever a second passes without a new frame
+class myAnalyzer   : public juce::Component,
+                            private juce::Timer,
+                            private juce::Thread,
+                            private juce::AsyncUpdater
+{
+public:
+    myAnalyzer(CompressorPieceAudioProcessor&);
+    ~myAnalyzer() override;
 
-    void getNextAudioBlock (const juce::AudioSourceChannelInfo&) override;
+    //the part of the editor background behind the analyzer, so it can paint
+    //itself opaquely without the editor repainting underneath it
+    void setBackground (const juce::Image&);
 
     //==============================================================================
     void paint (juce::Graphics& g) override
@@ -50,8 +68,21 @@ public:
         drawFrame (g);
     }
 
+    void resized() override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+
     void timerCallback() override;
+    void handleAsyncUpdate() override;
+    void run() override;
+
+    void startAnalysis();
+    void stopAnalysis();
 
+    //runs exactly while the analyzer is showing
+    void updateAnalysis();
+
+    void drainTap();
     void pushNextSampleIntoFifo (float, int) noexcept;
 
     void drawNextFrameOfSpectrum();
@@ -61,24 +92,83 @@ private:
     CompressorPieceAudioProcessor& audioProcessor;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (myAnalyzer)
 
-    juce::dsp::FFT fftOut;
-    juce::dsp::WindowingFunction<float> windowOut;
+    //one FFT and window for every analyzer in the process
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    std::shared_ptr<const SpectrumResources> spectrum;
+
     float fifoOut[fftSize];
     float fftDataOut[2*fftSize];
     int fifoOutIndex = 0;
     bool nextReadyOut = false;
     float scopeDataOut[scopeSize];
 
-    juce::dsp::FFT fftIn;
-    juce::dsp::WindowingFunction<float> windowIn;
     float fifoIn[fftSize];
     float fftDataIn[2*fftSize];
     int fifoInIndex = 0;
     bool nextReadyIn = false;
     float scopeDataIn[scopeSize];
 
+    juce::Path pathIn, pathOut;         //front buffer, read by paint
+    juce::Path nextPathIn, nextPathOut; //back buffer, written by the worker
+    juce::SpinLock pathLock;
+    std::atomic<bool> newFrameReady { false };
+    std::atomic<int> scopeHeight { 0 };
+
+    enum
+    {
+        frameRate = 30,
+        idleFramesBeforeSleep = frameRate
+    };
+
+    bool analysing = false;
+    int idleFrames = 0;
+    std::atomic<bool> timerSleeping { false };
+
+    Colors mycolors;
+    BackgroundCache background { mycolors.mylightPink };
+
+    //a component hears nothing when its window is minimised or restored, or
+    //when an ancestor is hidden; this watches the whole chain up to the peer,
+    //whose minimising arrives as a move or resize of the top-level component
+    struct ShowingWatcher   : public juce::ComponentMovementWatcher
+    {
+        ShowingWatcher (myAnalyzer& a) : juce::ComponentMovementWatcher (&a), analyzer (a) {}
+
+        void componentMovedOrResized (bool, bool) override  { analyzer.updateAnalysis(); }
+        void componentPeerChanged() override              { analyzer.updateAnalysis(); }
+        void componentVisibilityChanged() override        { analyzer.updateAnalysis(); }
+
+        myAnalyzer& analyzer;
+    };
+
+    //last, so it stops watching before anything above goes away
+    ShowingWatcher showingWatcher { *this };
+};
+
+#if POP_PRINCESS_TELEMETRY
+//per-stage p50/p99/max as a share of the block deadline; double-click writes
+//a Chrome trace of the most recent blocks to the desktop
+class TelemetryView   : public juce::Component,
+                               private juce::Timer
+{
+public:
+    TelemetryView(Telemetry&);
+
+    void paint (juce::Graphics& g) override;
+    void mouseDoubleClick (const juce::MouseEvent&) override;
+
+    void timerCallback() override;
+
+    void setEditorOpenTime (double milliseconds) { editorOpenMs = milliseconds; }
+
+private:
+    Telemetry& telemetry;
+    juce::String status;
+    double editorOpenMs = 0.0;
+
     Colors mycolors;
 };
+#endif
 
 
 
@@ -95,7 +185,17 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    //from the first member's construction to the end of the constructor
+    double getConstructionMilliseconds() const noexcept { return constructionMs; }
+
+    //what opening the editor should cost, on a session where another editor
+    //has already decoded the shared background
+    static constexpr double constructionBudgetMs = 20.0;
+
 private:
+    const double constructionStart = juce::Time::getMillisecondCounterHiRes();
+    double constructionMs = 0.0;
+
     CompressorPieceAudioProcessor& audioProcessor;
     
     juce::Slider threshDial, makeupDial, masterDial;
@@ -104,7 +204,16 @@ private:
 
     myAnalyzer analyzer { audioProcessor };
 
+   #if POP_PRINCESS_TELEMETRY
+    TelemetryView telemetryView { audioProcessor.getTelemetry() };
+   #endif
+
+    //decoded once for every editor in the process
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    std::shared_ptr<const juce::Image> sharedBackground;
+    juce::Image background;
     Colors mycolors;
+    BackgroundCache renderedBackground { mycolors.mylightPink };
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorPieceAudioProcessorEditor)
 };
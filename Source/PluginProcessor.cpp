@@ -31,12 +31,41 @@ CompressorPieceAudioProcessor::CompressorPieceAudioProcessor()
     makeupGain = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("Makeup"));
     jassert(amount != nullptr);
     
-    inBuff = juce::AudioSourceChannelInfo();
-    outBuff = juce::AudioSourceChannelInfo();
+    oversampling = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("Oversampling"));
+    jassert(oversampling != nullptr);
+    
+    linearPhase = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("LinearPhase"));
+    jassert(linearPhase != nullptr);
+    
+    glueLink = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("GlueLink"));
+    jassert(glueLink != nullptr);
+    
+    bandLink = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("BandLink"));
+    jassert(bandLink != nullptr);
+    
+    limiter = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("Limiter"));
+    jassert(limiter != nullptr);
+    
+    ceiling = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("Ceiling"));
+    jassert(ceiling != nullptr);
+    
+    lookahead = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("Lookahead"));
+    jassert(lookahead != nullptr);
+    
+    dsp.setAnalyzerTap(&analyzerTap);
+    dspDouble.setAnalyzerTap(&analyzerTap);
+    
+   #if POP_PRINCESS_TELEMETRY
+    dsp.setTelemetry(&telemetry);
+    dspDouble.setTelemetry(&telemetry);
+   #endif
+    
+    startTimerHz(10);
 }
 
 CompressorPieceAudioProcessor::~CompressorPieceAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -74,7 +103,7 @@ bool CompressorPieceAudioProcessor::isMidiEffect() const
 
 double CompressorPieceAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return isUsingDoublePrecision() ? dspDouble.getTailLengthSeconds() : dsp.getTailLengthSeconds();
 }
 
 int CompressorPieceAudioProcessor::getNumPrograms()
@@ -103,111 +132,58 @@ void CompressorPieceAudioProcessor::changeProgramName (int index, const juce::St
 //==============================================================================
 void CompressorPieceAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
-    
-    //filter
-    auto& filter = processorChain2.get<eqIndex>();
-    filter.state = FilterCoefs::makeHighShelf(spec.sampleRate, 2500.0f, 0.71f, juce::Decibels::decibelsToGain(0.0f));
-    
-    processorChain1.prepare(spec);
-    processorChain2.prepare(spec);
-    
-    //saturator begin
-    auto& gain1 = processorChain1.get<driveGainIndex>();
-    gain1.reset();
-    
-    auto& waveShaper = processorChain1.get<waveShaperIndex>();
-    waveShaper.reset();
-    waveShaper.functionToUse = [] (float x)
-    {
-        /*std::tanh(x);*/ /*juce::jlimit(-1.0f, 1.0f, x);*/
-        /*std::signbit(x)*(1.0-0.25/(std::abs(x)+0.25));*/
-        float f = 0;
-        if(abs(x) > 2/3)
-            f = signbit(x);
-        else
-            f = sin(3*M_PI*x/4);
-        return f;
-    };
-    
-    auto& gain2 = processorChain1.get<outGainIndex>();
-    gain2.reset();
-    //saturator end
-    
-    //compressor begin
-    auto& compressor = processorChain1.get<compressorIndex>();
-    compressor.reset();
-    compressor.setRatio(1.15f);
-    compressor.setAttack(1.0f);
-    compressor.setRelease(30.0f);
-    compressor.setThreshold(0.0f);
-    
-    auto& gain3 = processorChain1.get<compGainIndex>();
-    gain3.reset();
-    //compressor end
-    
-    //mb compressor begin
-    LP1.prepare(spec);
-    HP1.prepare(spec);
-    AP2.prepare(spec);
-    LP2.prepare(spec);
-    HP2.prepare(spec);
-    LP1.setType(juce::dsp::LinkwitzRileyFilterType::lowpass);
-    HP1.setType(juce::dsp::LinkwitzRileyFilterType::highpass);
-    AP2.setType(juce::dsp::LinkwitzRileyFilterType::allpass);
-    LP2.setType(juce::dsp::LinkwitzRileyFilterType::lowpass);
-    HP2.setType(juce::dsp::LinkwitzRileyFilterType::highpass);
-    for(auto& buffer : MBFilterBuffers)
-    {
-        buffer.setSize(spec.numChannels, samplesPerBlock);
-    }
-    LP1.setCutoffFrequency(88.3f);
-    HP1.setCutoffFrequency(88.3f);
-    AP2.setCutoffFrequency(2500.0f);
-    LP2.setCutoffFrequency(2500.0f);
-    HP2.setCutoffFrequency(2500.0f);
-    
-    LowBandComp.prepare(spec);
-    LowBandComp.reset();
-    LowBandComp.setRatio(66.7f);
-    LowBandComp.setAttack(47.8f);
-    LowBandComp.setRelease(282.0f);
-    LowBandComp.setThreshold(-33.8f);
-    
-    MidBandComp.prepare(spec);
-    MidBandComp.reset();
-    MidBandComp.setRatio(66.7f);
-    MidBandComp.setAttack(22.4f);
-    MidBandComp.setRelease(282.0f);
-    MidBandComp.setThreshold(-30.2f);
-    
-    HighBandComp.prepare(spec);
-    HighBandComp.reset();
-    HighBandComp.setRatio(100.0f);
-    HighBandComp.setAttack(13.5f);
-    HighBandComp.setRelease(282.0f);
-    HighBandComp.setThreshold(-35.5f);
-    
-    for( size_t i = 0; i < 3; ++i )
-    {
-        mbCompInGains[i].prepare(spec);
-        mbCompInGains[i].reset();
-        mbCompInGains[i].setGainDecibels(5.20f);
-        mbCompOutGains[i].prepare(spec);
-        mbCompOutGains[i].reset();
-    }
-    mbCompOutGains[0].setGainDecibels(10.3f);
-    mbCompOutGains[1].setGainDecibels(5.7f);
-    mbCompOutGains[2].setGainDecibels(10.3f);
-    //mb compressor end
+    //the band buffers and compressor lanes are sized from the current layout
+    spec.numChannels = getMainBusNumOutputChannels();
+    
+    //parameters first, so playback starts on them instead of gliding in from
+    //whatever the chain last had
+    auto parameters = getParameters();
+    dsp.setParameters(parameters);
+    dspDouble.setParameters(parameters);
+    
+    //the pool is joined here, off the audio thread and out of the noexcept
+    //setNonRealtime, which then only has to flip a flag
+    dsp.attachTaskPool();
+    dspDouble.attachTaskPool();
+    dsp.setParallelProcessing(isNonRealtime());
+    dspDouble.setParallelProcessing(isNonRealtime());
+    
+    if( isUsingDoublePrecision() )
+        dspDouble.prepare(spec);
+    else
+        dsp.prepare(spec);
+    
+    updateDSP();
+    
+    //the host expects the latency to be current once this returns
+    setLatencySamples(dspLatency.load());
 }
 
 void CompressorPieceAudioProcessor::releaseResources()
 {
 }
 
+void CompressorPieceAudioProcessor::reset()
+{
+    if( isUsingDoublePrecision() )
+        dspDouble.reset();
+    else
+        dsp.reset();
+}
+
+void CompressorPieceAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+    
+    //bounces may spread big blocks over a few threads; realtime never does.
+    //Switched here rather than per block; the pool itself was joined in prepareToPlay
+    dsp.setParallelProcessing(isNonRealtime);
+    dspDouble.setParallelProcessing(isNonRealtime);
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool CompressorPieceAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -215,8 +191,10 @@ bool CompressorPieceAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
     juce::ignoreUnused (layouts);
     return true;
   #else
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    //every channel is processed alike, so any set of up to maxChannels will do
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+    
+    if (numChannels < 1 || numChannels > maxChannels)
         return false;
 
    #if ! JucePlugin_IsSynth
@@ -229,32 +207,59 @@ bool CompressorPieceAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
 }
 #endif
 
-void CompressorPieceAudioProcessor::updateCompressor ()
+CompressorPieceParameters CompressorPieceAudioProcessor::getParameters () const
 {
-    auto& compressor = processorChain1.get<compressorIndex>();
-    compressor.setRatio(amount->get() / 100.0 * (4.0-1.15) + 1.15);
-    compressor.setThreshold(threshold->get());
+    CompressorPieceParameters parameters;
+    parameters.amount = amount->get();
+    parameters.threshold = threshold->get();
+    parameters.makeup = makeupGain->get();
+    parameters.oversamplingOrder = oversampling->getIndex();
+    parameters.linearPhase = linearPhase->get();
+    parameters.glueLink = (DetectorLink) glueLink->getIndex();
+    parameters.bandLink = (DetectorLink) bandLink->getIndex();
+    parameters.limiter = limiter->get();
+    parameters.ceiling = ceiling->get();
+    parameters.lookahead = lookahead->get();
+    
+    return parameters;
+}
+
+void CompressorPieceAudioProcessor::updateDSP ()
+{
+    //one read of every parameter per block, so the whole block sees a
+    //consistent set however the host or GUI is changing them meanwhile
+    auto parameters = getParameters();
+    
+    dsp.setParameters(parameters);
+    dspDouble.setParameters(parameters);
     
-    auto& gain = processorChain1.get<compGainIndex>();
-    gain.setGainDecibels(makeupGain->get());
+    //only realtime playback trades quality for keeping up
+    dsp.setQualityGovernor(! isNonRealtime());
+    dspDouble.setQualityGovernor(! isNonRealtime());
+    
+    dspLatency = isUsingDoublePrecision() ? dspDouble.getLatencySamples() : dsp.getLatencySamples();
 }
 
-void CompressorPieceAudioProcessor::updateWaveshaper ()
+void CompressorPieceAudioProcessor::timerCallback()
 {
-    auto& driveGain = processorChain1.get<driveGainIndex>();
-    driveGain.setGainDecibels(amount->get() / 100.0 * 35.0);
+    auto latency = dspLatency.load();
     
-    auto& outGain = processorChain1.get<outGainIndex>();
-    outGain.setGainDecibels(amount->get() / 100.0 * (0-35.0));
+    if( latency != getLatencySamples() )
+        setLatencySamples(latency);
 }
 
-void CompressorPieceAudioProcessor::updateEQ ()
+void CompressorPieceAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
 {
-    auto& eq = processorChain2.get<eqIndex>();
-    eq.state = FilterCoefs::makeHighShelf(spec.sampleRate, 2500.0f, 0.71f, juce::Decibels::decibelsToGain(amount->get() / 100.0 * (0-0.87)));
+    processSamples(buffer);
 }
 
-void CompressorPieceAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void CompressorPieceAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processSamples(buffer);
+}
+
+template <typename SampleType>
+void CompressorPieceAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -262,73 +267,13 @@ void CompressorPieceAudioProcessor::processBlock (juce::AudioBuffer<float>& buff
     
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
-
-    inputSig = buffer;
-    inBuff = juce::AudioSourceChannelInfo(inputSig);
-    
-    juce::dsp::AudioBlock<float> block (buffer);
-    
-    updateWaveshaper();
-    updateCompressor();
-    updateEQ();
-    
-    processorChain1.process(juce::dsp::ProcessContextReplacing <float> (block));
-    
-    // mb comp begin
-    for(auto& fb : MBFilterBuffers)
-    {
-        fb = buffer;
-    }
-    
-    auto fb0Block = juce::dsp::AudioBlock<float>(MBFilterBuffers[0]);
-    auto fb1Block = juce::dsp::AudioBlock<float>(MBFilterBuffers[1]);
-    auto fb2Block = juce::dsp::AudioBlock<float>(MBFilterBuffers[2]);
     
-    auto fb0Ctx = juce::dsp::ProcessContextReplacing<float>(fb0Block);
-    auto fb1Ctx = juce::dsp::ProcessContextReplacing<float>(fb1Block);
-    auto fb2Ctx = juce::dsp::ProcessContextReplacing<float>(fb2Block);
+    updateDSP();
     
-    LP1.process(fb0Ctx);
-    AP2.process(fb0Ctx);
-
-    HP1.process(fb1Ctx);
-    MBFilterBuffers[2] = MBFilterBuffers[1];
-    LP2.process(fb1Ctx);
-
-    HP2.process(fb2Ctx);
-    
-    auto numSamples = buffer.getNumSamples();
-    auto numChannels = buffer.getNumChannels();
-    
-    for( size_t i = 0; i < MBFilterBuffers.size(); ++i )
-    {
-        auto compblock = juce::dsp::AudioBlock<float>(MBFilterBuffers[i]);
-        auto compcontext = juce::dsp::ProcessContextReplacing<float>(compblock);
-        mbCompInGains[i].process(compcontext);
-        compressors[i].process(compcontext);
-        mbCompOutGains[i].process(compcontext);
-    }
-    
-    auto addFilterBand = [nc = numChannels, ns = numSamples](auto& inputBuffer, const auto& source, float &mix)
-    {
-        for(auto i = 0; i < nc; ++i)
-        {
-            inputBuffer.addFrom(i, 0, source, i, 0, ns, mix);
-        }
-    };
-    
-    float ottMix = amount->get() / 100.0 * 0.75;
-    
-    addFilterBand(buffer, MBFilterBuffers[0], ottMix);
-    addFilterBand(buffer, MBFilterBuffers[1], ottMix);
-    addFilterBand(buffer, MBFilterBuffers[2], ottMix);
-    //mb comp end
-    
-    juce::dsp::AudioBlock<float> block2 (buffer);
-    
-    processorChain2.process(juce::dsp::ProcessContextReplacing <float> (block2));
-
-    outBuff = juce::AudioSourceChannelInfo(buffer);
+    if constexpr (std::is_same_v<SampleType, double>)
+        dspDouble.process(juce::dsp::AudioBlock<double> (buffer));
+    else
+        dsp.process(juce::dsp::AudioBlock<float> (buffer));
 }
 
 //==============================================================================
@@ -380,6 +325,43 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorPieceAudioProcesso
                                                      NormalisableRange<float>(0, 20, 0.01),
                                                      0));
     
+    layout.add(std::make_unique<AudioParameterChoice>("Oversampling",
+                                                      "Oversampling",
+                                                      StringArray { "1x", "2x", "4x", "8x" },
+                                                      0));
+    
+    layout.add(std::make_unique<AudioParameterBool>("LinearPhase",
+                                                    "Linear Phase",
+                                                    false));
+    
+    //in DetectorLink order
+    layout.add(std::make_unique<AudioParameterChoice>("GlueLink",
+                                                      "Glue Link",
+                                                      StringArray { "Off", "Max", "Sum" },
+                                                      0));
+    
+    layout.add(std::make_unique<AudioParameterChoice>("BandLink",
+                                                      "Band Link",
+                                                      StringArray { "Off", "Max", "Sum" },
+                                                      0));
+    
+    layout.add(std::make_unique<AudioParameterBool>("Limiter",
+                                                    "Limiter",
+                                                    false));
+    
+    layout.add(std::make_unique<AudioParameterFloat>("Ceiling",
+                                                     "Ceiling",
+                                                     NormalisableRange<float>(-12, 0, 0.1),
+                                                     -0.3f));
+    
+    //milliseconds, up to LookaheadLimiter::maxLookaheadSeconds. Not automatable:
+    //it changes the latency, so the chain only takes it up on prepare or reset
+    layout.add(std::make_unique<AudioParameterFloat>("Lookahead",
+                                                     "Lookahead",
+                                                     NormalisableRange<float>(0.5, 5, 0.1),
+                                                     1.5f,
+                                                     AudioParameterFloatAttributes().withAutomatable(false)));
+    
     return layout;
 }
 
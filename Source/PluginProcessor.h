@@ -9,12 +9,14 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CompressorPieceDSP.h"
 
 //==============================================================================
 /**
 */
 
-class CompressorPieceAudioProcessor  : public juce::AudioProcessor
+class CompressorPieceAudioProcessor  : public juce::AudioProcessor,
+                                       private juce::Timer
 {
 public:
     //==============================================================================
@@ -24,12 +26,16 @@ public:
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void reset() override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -59,62 +65,53 @@ public:
     
     APVTS apvts {*this, nullptr, "Parameters", createParameterLayout()};
     
-    void updateCompressor ();
-    void updateWaveshaper ();
-    void updateEQ ();
+    //hands the current parameter values to the DSP and picks up its latency,
+    //which the message thread then reports to the host
+    void updateDSP ();
     
-    juce::AudioBuffer<float> inputSig;
-    juce::AudioSourceChannelInfo inBuff;
-    juce::AudioSourceChannelInfo outBuff;
+    //pre/post samples for the editor's analyzer
+    AnalyzerTap analyzerTap;
+    
+   #if POP_PRINCESS_TELEMETRY
+    Telemetry& getTelemetry() { return telemetry; }
+   #endif
     
     juce::AudioParameterFloat* amount { nullptr };
     juce::AudioParameterFloat* threshold { nullptr };
     juce::AudioParameterFloat* makeupGain { nullptr };
+    juce::AudioParameterChoice* oversampling { nullptr };
+    juce::AudioParameterBool* linearPhase { nullptr };
+    juce::AudioParameterChoice* glueLink { nullptr };
+    juce::AudioParameterChoice* bandLink { nullptr };
+    juce::AudioParameterBool* limiter { nullptr };
+    juce::AudioParameterFloat* ceiling { nullptr };
+    juce::AudioParameterFloat* lookahead { nullptr };
+    
+    //any discrete layout up to this many channels, the same in and out
+    static constexpr int maxChannels = 16;
     
 private:
     //==============================================================================
     
-    juce::dsp::ProcessSpec spec;
-    
-    enum
-    {
-        driveGainIndex,
-        waveShaperIndex,
-        outGainIndex,
-        compressorIndex,
-        compGainIndex,
-    };
+    //every parameter's current value, in the DSP's terms
+    CompressorPieceParameters getParameters () const;
     
-    enum
-    {
-        eqIndex
-    };
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer);
     
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using FilterCoefs = juce::dsp::IIR::Coefficients<float>;
+    //setLatencySamples notifies the host and wrapper synchronously, so the
+    //audio thread only publishes the chain's latency and this reports it
+    void timerCallback() override;
+    std::atomic<int> dspLatency { 0 };
     
-    using MBFilter = juce::dsp::LinkwitzRileyFilter<float>;
-    MBFilter LP1, AP2, HP1, LP2, HP2;
-    std::array<juce::AudioBuffer<float>, 3> MBFilterBuffers;
+    //the whole signal chain, shared with the offline tools; only the one
+    //matching the host's processing precision is prepared and run
+    CompressorPieceDSP<float> dsp;
+    CompressorPieceDSP<double> dspDouble;
     
-    juce::dsp::ProcessorChain<juce::dsp::Gain<float>, //begin saturator
-                              juce::dsp::WaveShaper<float>,
-                              juce::dsp::Gain<float>, //end of saturator
-                              juce::dsp::Compressor<float>, //begin compressor
-                              juce::dsp::Gain<float> //end of compressor
-    > processorChain1;
-    
-    std::array<juce::dsp::Compressor<float>, 3> compressors;
-    juce::dsp::Compressor<float>& LowBandComp = compressors[0];
-    juce::dsp::Compressor<float>& MidBandComp = compressors[1];
-    juce::dsp::Compressor<float>& HighBandComp = compressors[2];
-    
-    std::array<juce::dsp::Gain<float>, 3> mbCompInGains;
-    std::array<juce::dsp::Gain<float>, 3> mbCompOutGains;
-    
-    juce::dsp::ProcessorChain<
-                              juce::dsp::ProcessorDuplicator<Filter, FilterCoefs> //high shelf eq
-    > processorChain2;
+   #if POP_PRINCESS_TELEMETRY
+    Telemetry telemetry;
+   #endif
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorPieceAudioProcessor)
 };
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Picks a quality tier from how long each block took against its deadline.
+
+    The audio thread reports every processed block's duration. The load, time
+    over deadline, is smoothed over about 50 ms; while it stays above
+    stepDownLoad for a quarter of a second the tier drops by one, and while it
+    stays below stepUpLoad for two seconds it rises by one. The wide gap and
+    the longer wait to step up stop it see-sawing between two tiers whose
+    costs straddle the limit.
+
+    It only chooses; CompressorPieceDSP applies each tier and fades between
+    them.
+*/
+class QualityGovernor
+{
+public:
+    enum Tier
+    {
+        full,           //everything as designed
+        coarseControl,  //derived values recomputed 4x less often during glides
+        noShelf,        //and the shelf skipped while it is within shelfSkipDecibels of flat
+        cheapSaturator, //and a cubic curve in place of the sine
+        numTiers
+    };
+
+    static const char* getTierName (int tier) noexcept
+    {
+        static const char* const names[] = { "full", "coarseControl", "noShelf", "cheapSaturator" };
+        return names[tier];
+    }
+
+    void prepare (double newSampleRate) noexcept
+    {
+        jassert (newSampleRate > 0);
+
+        sampleRate = newSampleRate;
+        ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+        reset();
+    }
+
+    /** Back to full quality with no history. */
+    void reset () noexcept
+    {
+        tier = full;
+        load = 0.0;
+        pressureSeconds = headroomSeconds = 0.0;
+    }
+
+    /** Audio thread: a block of numSamples took elapsedTicks of the high
+        resolution clock. Returns the tier to run from the next block on.
+    */
+    int update (juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        if( numSamples <= 0 )
+            return tier;
+
+        auto blockSeconds = numSamples / sampleRate;
+        auto blockLoad = (double) elapsedTicks / ticksPerSecond / blockSeconds;
+
+        load += (blockLoad - load) * (1.0 - std::exp (-blockSeconds / loadSmoothingSeconds));
+
+        if( load > stepDownLoad )
+        {
+            pressureSeconds += blockSeconds;
+            headroomSeconds = 0.0;
+        }
+        else if( load < stepUpLoad )
+        {
+            headroomSeconds += blockSeconds;
+            pressureSeconds = 0.0;
+        }
+        else
+        {
+            pressureSeconds = headroomSeconds = 0.0;
+        }
+
+        if( pressureSeconds >= stepDownSeconds && tier < numTiers - 1 )
+        {
+            ++tier;
+            pressureSeconds = 0.0;
+        }
+        else if( headroomSeconds >= stepUpSeconds && tier > full )
+        {
+            --tier;
+            headroomSeconds = 0.0;
+        }
+
+        return tier;
+    }
+
+    int getTier () const noexcept           { return tier; }
+
+    /** Smoothed time over deadline; 1 means every block only just made it. */
+    double getLoad () const noexcept        { return load; }
+
+    static constexpr double stepDownLoad = 0.75;
+    static constexpr double stepUpLoad = 0.4;
+    static constexpr float shelfSkipDecibels = 0.2f;
+
+private:
+    static constexpr double loadSmoothingSeconds = 0.05;
+    static constexpr double stepDownSeconds = 0.25;
+    static constexpr double stepUpSeconds = 2.0;
+
+    double sampleRate { 44100.0 }, ticksPerSecond { 1.0 };
+    int tier { full };
+    double load { 0.0 }, pressureSeconds { 0.0 }, headroomSeconds { 0.0 };
+};
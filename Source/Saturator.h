@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    Saturator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/**
+    Drive, waveshaper and compensation gain in a single loop.
+
+    The curve is sin(3 pi x / 4) up to |x| = 2/3, where it reaches +/-1 with zero
+    slope, and hard clips beyond. Clamping the input first and evaluating the
+    sine as an odd polynomial with compile-time coefficients keeps the loop
+    free of calls and branches, so it vectorises.
+
+    New gains are ramped to linearly across the next block processed, so a
+    caller that changes them every control period gets a per-sample ramp
+    between its control points; reset() jumps straight to them. The mix
+    towards cheapShape is ramped the same way.
+*/
+template <typename SampleType>
+class Saturator
+{
+public:
+    void prepare (const juce::dsp::ProcessSpec&) noexcept {}
+    void reset() noexcept { driveGain = targetDriveGain; outputGain = targetOutputGain; cheapAmount = targetCheapAmount; }
+    
+    void setDriveDecibels (SampleType newDriveDecibels) noexcept       { targetDriveGain = juce::Decibels::decibelsToGain(newDriveDecibels, static_cast<SampleType> (-300.0)); }
+    void setDriveGainLinear (SampleType newDriveGain) noexcept         { targetDriveGain = newDriveGain; }
+    void setOutputGainDecibels (SampleType newGainDecibels) noexcept   { targetOutputGain = juce::Decibels::decibelsToGain(newGainDecibels, static_cast<SampleType> (-300.0)); }
+    void setOutputGainLinear (SampleType newGain) noexcept             { targetOutputGain = newGain; }
+    
+    /** 0 runs shape, 1 runs cheapShape, anything between mixes the two. */
+    void setCheapCurveAmount (SampleType newAmount) noexcept           { targetCheapAmount = juce::jlimit(SampleType(), static_cast<SampleType> (1), newAmount); }
+    
+    /** The shaping curve on its own, without drive or output gain. */
+    static SampleType shape (SampleType x) noexcept
+    {
+        constexpr auto knee = static_cast<SampleType> (2.0 / 3.0);
+        x = x < -knee ? -knee : (x > knee ? knee : x);
+        
+        auto x2 = x * x;
+        return x * (c1 + x2 * (c3 + x2 * (c5 + x2 * (c7 + x2 * (c9 + x2 * c11)))));
+    }
+    
+    /** A cubic with the same knee, reaching +/-1 there with zero slope, for
+        when there isn't time for the sine. Within 0.02 of it.
+    */
+    static SampleType cheapShape (SampleType x) noexcept
+    {
+        constexpr auto knee = static_cast<SampleType> (2.0 / 3.0);
+        x = x < -knee ? -knee : (x > knee ? knee : x);
+        
+        auto u = x * static_cast<SampleType> (1.5);
+        return u * (static_cast<SampleType> (1.5) - static_cast<SampleType> (0.5) * u * u);
+    }
+    
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        auto&& inputBlock = context.getInputBlock();
+        auto&& outputBlock = context.getOutputBlock();
+        
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == outputBlock.getNumSamples());
+        
+        if( context.isBypassed )
+        {
+            if( context.usesSeparateInputAndOutputBlocks() )
+                outputBlock.copyFrom(inputBlock);
+            
+            return;
+        }
+        
+        auto numSamples = outputBlock.getNumSamples();
+        auto drive = driveGain;
+        auto gain = outputGain;
+        auto cheap = cheapAmount;
+        
+        if( drive == targetDriveGain && gain == targetOutputGain && cheap == targetCheapAmount )
+        {
+            if( cheap == SampleType() )
+                processSteady(inputBlock, outputBlock, [] (SampleType x) { return shape(x); });
+            else if( cheap == static_cast<SampleType> (1) )
+                processSteady(inputBlock, outputBlock, [] (SampleType x) { return cheapShape(x); });
+            else
+                processSteady(inputBlock, outputBlock, [cheap] (SampleType x) { return mixShapes(x, cheap); });
+            
+            return;
+        }
+        
+        //the ramp reaches the targets on the block's last sample
+        auto driveStep = (targetDriveGain - drive) / static_cast<SampleType> (numSamples);
+        auto gainStep = (targetOutputGain - gain) / static_cast<SampleType> (numSamples);
+        auto cheapStep = (targetCheapAmount - cheap) / static_cast<SampleType> (numSamples);
+        
+        for( size_t ch = 0; ch < outputBlock.getNumChannels(); ++ch )
+        {
+            auto* in = inputBlock.getChannelPointer(ch);
+            auto* out = outputBlock.getChannelPointer(ch);
+            
+            for( size_t i = 0; i < numSamples; ++i )
+            {
+                auto n = static_cast<SampleType> (i + 1);
+                out[i] = mixShapes(in[i] * (drive + n * driveStep), cheap + n * cheapStep) * (gain + n * gainStep);
+            }
+        }
+        
+        driveGain = targetDriveGain;
+        outputGain = targetOutputGain;
+        cheapAmount = targetCheapAmount;
+    }
+    
+private:
+    static SampleType mixShapes (SampleType x, SampleType cheap) noexcept
+    {
+        auto full = shape(x);
+        return full + cheap * (cheapShape(x) - full);
+    }
+    
+    template <typename InputBlock, typename OutputBlock, typename Curve>
+    void processSteady (const InputBlock& inputBlock, const OutputBlock& outputBlock, Curve curve) const noexcept
+    {
+        auto numSamples = outputBlock.getNumSamples();
+        
+        for( size_t ch = 0; ch < outputBlock.getNumChannels(); ++ch )
+        {
+            auto* in = inputBlock.getChannelPointer(ch);
+            auto* out = outputBlock.getChannelPointer(ch);
+            
+            for( size_t i = 0; i < numSamples; ++i )
+                out[i] = curve(in[i] * driveGain) * outputGain;
+        }
+    }
+    
+    //Taylor coefficients of sin(k x) with k = 3 pi / 4, accurate to ~6e-8 at the knee
+    static constexpr SampleType k = static_cast<SampleType> (0.75 * 3.14159265358979323846);
+    static constexpr SampleType c1 = k;
+    static constexpr SampleType c3 = -c1 * k * k / static_cast<SampleType> (2 * 3);
+    static constexpr SampleType c5 = -c3 * k * k / static_cast<SampleType> (4 * 5);
+    static constexpr SampleType c7 = -c5 * k * k / static_cast<SampleType> (6 * 7);
+    static constexpr SampleType c9 = -c7 * k * k / static_cast<SampleType> (8 * 9);
+    static constexpr SampleType c11 = -c9 * k * k / static_cast<SampleType> (10 * 11);
+    
+    SampleType driveGain = 1, outputGain = 1, targetDriveGain = 1, targetOutputGain = 1;
+    SampleType cheapAmount = 0, targetCheapAmount = 0;
+};
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    SharedResources.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
+
+//==============================================================================
+/**
+    Read-only data that every instance would otherwise build for itself,
+    shared across the whole process.
+
+    Resources are keyed by their type, a sample rate and an FFT order (0 for
+    the sample rate, or the order, when a resource doesn't depend on it). The
+    first get for a key builds the resource; later ones get the same object
+    for as long as anyone still holds it, and it is freed with its last
+    holder. Everything handed out is const, so holders can use it from any
+    thread without locking.
+
+    Hold one through juce::SharedResourcePointer, like TaskPool, so the
+    registry itself goes when the last instance does.
+*/
+class SharedResources
+{
+public:
+    SharedResources() = default;
+
+    /** The resource for this key, calling create() for a
+        std::shared_ptr<Resource> if nobody holds one. Takes a lock, so call
+        it while preparing, never from the audio thread.
+    */
+    template <typename Resource, typename Create>
+    std::shared_ptr<const Resource> get (double sampleRate, int order, Create&& create)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        if( ! sharing )
+            return std::shared_ptr<const Resource> (create());
+
+        removeExpired();
+
+        auto& entry = entries[Key { std::type_index (typeid (Resource)), sampleRate, order }];
+
+        if( auto existing = entry.lock() )
+            return std::static_pointer_cast<const Resource> (existing);
+
+        std::shared_ptr<const Resource> created (create());
+        entry = created;
+        return created;
+    }
+
+    /** Holders of the resource for this key, 0 if there is none; for
+        checking that instances really do share it.
+    */
+    template <typename Resource>
+    long getUseCount (double sampleRate, int order)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        auto it = entries.find(Key { std::type_index (typeid (Resource)), sampleRate, order });
+        return it != entries.end() ? it->second.use_count() : 0;
+    }
+
+    /** Resources currently alive. */
+    int getNumResources ()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        removeExpired();
+        return (int) entries.size();
+    }
+
+    /** With sharing off every get builds a private copy, as if there were no
+        registry; only for measuring what sharing saves.
+    */
+    void setSharing (bool shouldShare)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        sharing = shouldShare;
+    }
+
+private:
+    struct Key
+    {
+        std::type_index type;
+        double sampleRate;
+        int order;
+
+        bool operator< (const Key& other) const noexcept
+        {
+            return std::tie(type, sampleRate, order) < std::tie(other.type, other.sampleRate, other.order);
+        }
+    };
+
+    void removeExpired ()
+    {
+        for( auto it = entries.begin(); it != entries.end(); )
+            it = it->second.expired() ? entries.erase(it) : std::next(it);
+    }
+
+    std::mutex mutex;
+    std::map<Key, std::weak_ptr<const void>> entries;
+    bool sharing { true };
+
+    JUCE_DECLARE_NON_COPYABLE (SharedResources)
+};
+
+//==============================================================================
+/** The FFT and normalised Hann window for one spectrum analyzer size, shared
+    by every analyzer of that size. The FFT is only used through its const
+    members, and the window is a plain table for multiplyWithWindow.
+*/
+struct SpectrumResources
+{
+    explicit SpectrumResources (int order)
+        : fft (order),
+          window ((size_t) 1 << order)
+    {
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), window.size(),
+                                                                 juce::dsp::WindowingFunction<float>::hann, true);
+    }
+
+    void multiplyWithWindow (float* samples) const noexcept
+    {
+        juce::FloatVectorOperations::multiply(samples, window.data(), (int) window.size());
+    }
+
+    static std::shared_ptr<const SpectrumResources> get (SharedResources& resources, int order)
+    {
+        return resources.get<SpectrumResources>(0.0, order, [order] { return std::make_shared<SpectrumResources>(order); });
+    }
+
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+};
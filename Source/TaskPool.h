@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    TaskPool.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//==============================================================================
+/**
+    A few persistent worker threads for splitting one block's work.
+
+    tryRun hands out task indices to the workers and the calling thread from a
+    shared counter and returns once every task is done. The threads are
+    created once and sleep between jobs. It waits on mutexes and condition
+    variables, so it is only for offline rendering, never the audio thread
+    of a realtime host.
+
+    One pool is shared by every chain in the process (see
+    juce::SharedResourcePointer). A caller that finds it busy with someone
+    else's job gets false back straight away and does the work itself.
+*/
+class TaskPool
+{
+public:
+    TaskPool() : TaskPool (juce::jlimit(1, 7, juce::SystemStats::getNumCpus() - 1)) {}
+
+    explicit TaskPool (int numWorkers)
+    {
+        for( int i = 0; i < numWorkers; ++i )
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            quit = true;
+        }
+
+        wake.notify_all();
+
+        for( auto& worker : workers )
+            worker.join();
+    }
+
+    /** Workers plus the calling thread. */
+    int getNumThreads () const noexcept     { return (int) workers.size() + 1; }
+
+    /** Calls task(i) for every i in [0, numTasks), spread over the pool, and
+        returns true when they have all finished. Returns false without
+        calling anything if another thread is using the pool.
+    */
+    template <typename Task>
+    bool tryRun (int numTasks, Task& task)
+    {
+        std::unique_lock<std::mutex> callerLock (callerMutex, std::try_to_lock);
+
+        if( ! callerLock.owns_lock() )
+            return false;
+
+        {
+            //no worker may still be looking at the previous job's counters
+            std::unique_lock<std::mutex> lock (mutex);
+            done.wait(lock, [this] { return busyWorkers == 0; });
+
+            job = [] (void* context, int index) { (*static_cast<Task*> (context))(index); };
+            jobContext = &task;
+            jobSize.store(numTasks);
+            remaining.store(numTasks);
+            nextTask.store(0);
+            ++generation;
+        }
+
+        wake.notify_all();
+        work();
+
+        std::unique_lock<std::mutex> lock (mutex);
+        done.wait(lock, [this] { return remaining.load() == 0 && busyWorkers == 0; });
+        return true;
+    }
+
+private:
+    void work ()
+    {
+        for( ;; )
+        {
+            auto index = nextTask.fetch_add(1);
+
+            if( index >= jobSize.load() )
+                return;
+
+            job(jobContext, index);
+
+            if( remaining.fetch_sub(1) == 1 )
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                done.notify_all();
+            }
+        }
+    }
+
+    void workerLoop ()
+    {
+        juce::uint64 seen = 0;
+
+        for( ;; )
+        {
+            {
+                std::unique_lock<std::mutex> lock (mutex);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+
+                if( quit )
+                    return;
+
+                seen = generation;
+                ++busyWorkers;
+            }
+
+            work();
+
+            std::lock_guard<std::mutex> lock (mutex);
+            --busyWorkers;
+            done.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+
+    std::mutex callerMutex, mutex;
+    std::condition_variable wake, done;
+    juce::uint64 generation { 0 };
+    int busyWorkers { 0 };
+    bool quit { false };
+
+    void (*job) (void*, int) { nullptr };
+    void* jobContext { nullptr };
+    std::atomic<int> jobSize { 0 }, remaining { 0 }, nextTask { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (TaskPool)
+};
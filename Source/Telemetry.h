@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    Telemetry.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+/** Build with POP_PRINCESS_TELEMETRY=1 to time every stage of every block.
+    When it is 0 the processor holds no Telemetry and the timing calls are not
+    compiled at all.
+*/
+#ifndef POP_PRINCESS_TELEMETRY
+ #define POP_PRINCESS_TELEMETRY 0
+#endif
+
+//==============================================================================
+/**
+    Per-stage timings of the audio thread, measured against the block deadline.
+
+    The audio thread brackets each host block with beginBlock/endBlock and
+    calls endStage as each stage finishes, once per tile or segment the
+    block is split into; a stage's times add up across them. Timings come from the high resolution
+    tick counter, which is the CPU's cycle-derived clock on every platform
+    JUCE supports and, unlike raw TSC reads, is comparable across cores.
+
+    Each block goes into a fixed ring that the audio thread overwrites
+    without waiting, and into one histogram per stage of its time as a
+    fraction of the block's duration. Both are read from other threads
+    without locking: getStats for display, writeChromeTrace for a trace
+    that chrome://tracing or Perfetto can open. The QualityGovernor tier
+    each block ran at is recorded with it.
+*/
+class Telemetry
+{
+public:
+    enum Stage
+    {
+        saturator,
+        crossover,
+        bandCompressors,
+        bandSum,
+        eq,
+        limiter,
+        total,
+        numStages
+    };
+
+    static const char* getStageName (int stage) noexcept
+    {
+        static const char* const names[] = { "saturator", "crossover", "bandCompressors", "bandSum", "eq", "limiter", "total" };
+        return names[stage];
+    }
+
+    struct Stats
+    {
+        //fractions of the block deadline
+        float p50 { 0.0f }, p99 { 0.0f }, max { 0.0f };
+        juce::uint64 numBlocks { 0 };
+    };
+
+    Telemetry()
+    {
+        records.calloc(ringSize);
+        resetStats();
+    }
+
+    //==============================================================================
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    }
+
+    /** Audio thread: start timing a block of numSamples. */
+    void beginBlock (int numSamples) noexcept
+    {
+        current.startTicks = current.stageStartTicks = juce::Time::getHighResolutionTicks();
+        current.numSamples = (juce::uint32) numSamples;
+        std::fill(std::begin(current.stageTicks), std::end(current.stageTicks), 0u);
+    }
+
+    /** Audio thread: the given stage has just finished. */
+    void endStage (Stage stage) noexcept
+    {
+        auto now = juce::Time::getHighResolutionTicks();
+        current.stageTicks[stage] += (juce::uint32) (now - current.stageStartTicks);
+        current.stageStartTicks = now;
+    }
+
+    /** Audio thread: the quality tier blocks run at from now on. */
+    void setQualityTier (int tier) noexcept
+    {
+        qualityTier.store(tier, std::memory_order_relaxed);
+    }
+
+    /** Any thread: the tier of the most recent block. */
+    int getQualityTier () const noexcept     { return qualityTier.load(std::memory_order_relaxed); }
+
+    /** Audio thread: publish the block. */
+    void endBlock () noexcept
+    {
+        current.stageTicks[total] = (juce::uint32) (current.stageStartTicks - current.startTicks);
+        current.qualityTier = (juce::uint32) qualityTier.load(std::memory_order_relaxed);
+
+        auto deadlineTicks = current.numSamples * ticksPerSecond / sampleRate;
+
+        for( int stage = 0; stage < numStages; ++stage )
+        {
+            auto fraction = (float) (current.stageTicks[stage] / deadlineTicks);
+            auto bin = juce::jlimit(0, numBins - 1, (int) (fraction * binsPerDeadline));
+            histograms[stage][bin].fetch_add(1, std::memory_order_relaxed);
+
+            if( fraction > maxima[stage].load(std::memory_order_relaxed) )
+                maxima[stage].store(fraction, std::memory_order_relaxed);
+        }
+
+        auto index = writeIndex.load(std::memory_order_relaxed);
+        records[index & (ringSize - 1)] = current;
+        writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    //==============================================================================
+    /** Any thread: percentiles for one stage since the last resetStats. */
+    Stats getStats (Stage stage) const noexcept
+    {
+        std::array<juce::uint64, numBins> counts;
+        Stats stats;
+
+        for( int bin = 0; bin < numBins; ++bin )
+        {
+            counts[(size_t) bin] = histograms[stage][bin].load(std::memory_order_relaxed);
+            stats.numBlocks += counts[(size_t) bin];
+        }
+
+        auto percentile = [&] (double p)
+        {
+            auto target = (juce::uint64) std::ceil(p * (double) stats.numBlocks);
+            juce::uint64 seen = 0;
+
+            for( int bin = 0; bin < numBins; ++bin )
+            {
+                seen += counts[(size_t) bin];
+
+                if( seen >= target && seen > 0 )
+                    return (float) (bin + 1) / binsPerDeadline;
+            }
+
+            return 0.0f;
+        };
+
+        stats.p50 = percentile(0.5);
+        stats.p99 = percentile(0.99);
+        stats.max = maxima[stage].load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /** Any thread: clears the histograms; the trace ring is left as it is. */
+    void resetStats () noexcept
+    {
+        for( auto& histogram : histograms )
+            for( auto& bin : histogram )
+                bin.store(0, std::memory_order_relaxed);
+
+        for( auto& maximum : maxima )
+            maximum.store(0.0f, std::memory_order_relaxed);
+    }
+
+    /** Any thread: writes the most recent blocks as Chrome trace events. */
+    juce::Result writeChromeTrace (const juce::File& file) const
+    {
+        //records the audio thread may be overwriting while we copy are skipped
+        constexpr juce::uint64 safetyMargin = 64;
+
+        auto end = writeIndex.load(std::memory_order_acquire);
+        auto available = juce::jmin(end, (juce::uint64) ringSize - safetyMargin);
+
+        juce::Array<juce::var> events;
+        auto toMicroseconds = [this] (juce::int64 ticks) { return (double) ticks * 1.0e6 / ticksPerSecond; };
+
+        auto addEvent = [&events] (const char* name, double start, double duration, juce::var args = {})
+        {
+            auto* event = new juce::DynamicObject();
+            event->setProperty("name", name);
+            event->setProperty("cat", "dsp");
+            event->setProperty("ph", "X");
+            event->setProperty("pid", 1);
+            event->setProperty("tid", 1);
+            event->setProperty("ts", start);
+            event->setProperty("dur", duration);
+
+            if( ! args.isVoid() )
+                event->setProperty("args", args);
+
+            events.add(event);
+        };
+
+        for( auto index = end - available; index < end; ++index )
+        {
+            auto record = records[index & (ringSize - 1)];
+            auto start = record.startTicks;
+
+            auto* blockArgs = new juce::DynamicObject();
+            blockArgs->setProperty("qualityTier", (int) record.qualityTier);
+
+            addEvent("block", toMicroseconds(start), toMicroseconds(record.stageTicks[total]), juce::var (blockArgs));
+
+            for( int stage = 0; stage < total; ++stage )
+            {
+                addEvent(getStageName(stage), toMicroseconds(start), toMicroseconds(record.stageTicks[stage]));
+                start += record.stageTicks[stage];
+            }
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("traceEvents", events);
+        root->setProperty("displayTimeUnit", "ns");
+
+        if( ! file.replaceWithText(juce::JSON::toString(juce::var (root))) )
+            return juce::Result::fail("Can't write " + file.getFullPathName());
+
+        return juce::Result::ok();
+    }
+
+private:
+    //==============================================================================
+    enum
+    {
+        ringSize = 1 << 13,
+        binsPerDeadline = 200,
+        numBins = 2 * binsPerDeadline + 1 //up to twice the deadline, then overflow
+    };
+
+    struct Record
+    {
+        juce::int64 startTicks, stageStartTicks;
+        juce::uint32 numSamples, qualityTier;
+        juce::uint32 stageTicks[numStages];
+    };
+
+    double sampleRate { 44100.0 }, ticksPerSecond { 1.0 };
+    Record current {};
+
+    juce::HeapBlock<Record> records;
+    std::atomic<juce::uint64> writeIndex { 0 };
+    std::atomic<int> qualityTier { 0 };
+
+    std::array<std::array<std::atomic<juce::uint32>, numBins>, numStages> histograms;
+    std::array<std::atomic<float>, numStages> maxima;
+
+    JUCE_DECLARE_NON_COPYABLE (Telemetry)
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    AllocationTests.cpp
+
+    Drives processBlock through every oversampling, limiter and link mode
+    with blocks longer than prepareToPlay promised, and fails on any heap
+    allocation made while it runs.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+namespace
+{
+    //allocations are only counted while a test has switched counting on, and
+    //only on that test's thread; JUCE's timer thread may allocate meanwhile
+    std::atomic<bool> counting { false };
+    std::thread::id countingThread;
+    std::atomic<int> allocations { 0 };
+
+    void noteAllocation () noexcept
+    {
+        if( counting.load(std::memory_order_acquire) && std::this_thread::get_id() == countingThread )
+            allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template <typename Function>
+    int countAllocations (Function&& function)
+    {
+        allocations = 0;
+        countingThread = std::this_thread::get_id();
+        counting.store(true, std::memory_order_release);
+
+        function();
+
+        counting.store(false, std::memory_order_release);
+        return allocations.load();
+    }
+}
+
+//==============================================================================
+//With glibc, malloc and friends are replaced too, so the C allocations JUCE
+//makes (HeapBlock, for one) are caught as well as new. Elsewhere only new is.
+#if defined (__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+
+    void* malloc (size_t size) noexcept                     { noteAllocation(); return __libc_malloc(size); }
+    void* calloc (size_t count, size_t size) noexcept       { noteAllocation(); return __libc_calloc(count, size); }
+    void* realloc (void* pointer, size_t size) noexcept     { noteAllocation(); return __libc_realloc(pointer, size); }
+}
+
+static void* allocateUncounted (std::size_t size)           { return __libc_malloc(size); }
+#else
+static void* allocateUncounted (std::size_t size)           { return std::malloc(size); }
+#endif
+
+//The standard library's array, nothrow and sized forms all forward to these.
+void* operator new (std::size_t size)
+{
+    noteAllocation();
+
+    if( auto* pointer = allocateUncounted(size > 0 ? size : 1) )
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    noteAllocation();
+
+   #if JUCE_WINDOWS
+    if( auto* pointer = _aligned_malloc(size > 0 ? size : 1, (size_t) alignment) )
+        return pointer;
+   #else
+    void* pointer = nullptr;
+
+    if( posix_memalign(&pointer, juce::jmax(sizeof(void*), (size_t) alignment), size > 0 ? size : 1) == 0 )
+        return pointer;
+   #endif
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* pointer, std::align_val_t) noexcept
+{
+   #if JUCE_WINDOWS
+    _aligned_free(pointer);
+   #else
+    std::free(pointer);
+   #endif
+}
+
+//==============================================================================
+class ProcessBlockAllocationTest  : public juce::UnitTest
+{
+public:
+    ProcessBlockAllocationTest() : juce::UnitTest ("processBlock allocations", "Allocation") {}
+
+    void runTest() override
+    {
+        beginTest("Single precision");
+        runEveryMode<float>();
+
+        beginTest("Double precision");
+        runEveryMode<double>();
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int samplesPerBlock = 512;
+    static constexpr int blocksPerMode = 4;
+
+    static void setParameter (CompressorPieceAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(id);
+        jassert (parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    template <typename SampleType>
+    void runEveryMode ()
+    {
+        CompressorPieceAudioProcessor processor;
+
+        if constexpr (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        processor.prepareToPlay(sampleRate, samplesPerBlock);
+
+        //every stage busy: the saturator, a glue compressor well over threshold
+        setParameter(processor, "Amount", 60.0f);
+        setParameter(processor, "Threshold", -24.0f);
+        setParameter(processor, "Makeup", 3.0f);
+
+        //longer than prepareToPlay promised, so process() has to chunk it
+        juce::AudioBuffer<SampleType> buffer (processor.getTotalNumOutputChannels(), 3 * samplesPerBlock + 17);
+        juce::MidiBuffer midi;
+        juce::Random random (0x5eed);
+
+        for( int order = 0; order < 4; ++order )
+            for( auto linear : { false, true } )
+                for( auto limit : { false, true } )
+                    for( int glue = 0; glue < 3; ++glue )
+                        for( int band = 0; band < 3; ++band )
+                        {
+                            setParameter(processor, "Oversampling", (float) order);
+                            setParameter(processor, "LinearPhase", linear ? 1.0f : 0.0f);
+                            setParameter(processor, "Limiter", limit ? 1.0f : 0.0f);
+                            setParameter(processor, "Lookahead", glue == band ? 5.0f : 1.5f);
+                            setParameter(processor, "GlueLink", (float) glue);
+                            setParameter(processor, "BandLink", (float) band);
+
+                            //the lookahead is only taken up here, as a host would between runs
+                            processor.reset();
+
+                            int count = 0;
+
+                            for( int block = 0; block < blocksPerMode; ++block )
+                            {
+                                for( int channel = 0; channel < buffer.getNumChannels(); ++channel )
+                                    for( int i = 0; i < buffer.getNumSamples(); ++i )
+                                        buffer.setSample(channel, i, (SampleType) (random.nextFloat() - 0.5f));
+
+                                count += countAllocations([&] { processor.processBlock(buffer, midi); });
+                            }
+
+                            expectEquals(count, 0, "oversampling order " + juce::String(order)
+                                                   + (linear ? ", linear phase" : ", minimum phase")
+                                                   + (limit ? ", limiter" : "")
+                                                   + (glue == band ? ", 5 ms lookahead" : "")
+                                                   + ", glue link " + juce::String(glue)
+                                                   + ", band link " + juce::String(band));
+                        }
+
+        processor.releaseResources();
+    }
+};
+
+static ProcessBlockAllocationTest processBlockAllocationTest;
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    BatchTests.cpp
+
+    CompressorPieceBatch must render each stream as a CompressorPieceDSP of
+    its own would: runs mono and stereo noise streams through one batch and
+    through one chain per stream, in every oversampling mode, and compares
+    them. One stream goes silent for longer than the tail, so its own chain
+    sleeps while the batch keeps running; that divergence is allowed only
+    until the stream has been playing again for two tail lengths.
+
+  ==============================================================================
+*/
+
+#include "CompressorPieceBatch.h"
+
+class BatchEquivalenceTest  : public juce::UnitTest
+{
+public:
+    BatchEquivalenceTest() : juce::UnitTest ("Batch engine", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("Single precision");
+        runEveryMode<float>(1.0e-6);
+
+        beginTest("Double precision");
+        runEveryMode<double>(1.0e-12);
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+    static constexpr int numStreams = 4;
+
+    //-120 dB, the chain's own silence threshold: what a sleeping chain's
+    //output may differ from one that keeps running
+    static constexpr double sleepTolerance = 1.0e-6;
+
+    template <typename SampleType>
+    void runEveryMode (double tolerance)
+    {
+        for( auto channelsPerStream : { 1, 2 } )
+        {
+            for( int order = 0; order < 4; ++order )
+            {
+                CompressorPieceParameters parameters;
+                parameters.amount = 60.0f;
+                parameters.threshold = -24.0f;
+                parameters.makeup = 3.0f;
+                parameters.oversamplingOrder = order;
+
+                compare<SampleType>(parameters, channelsPerStream, tolerance,
+                                    juce::String(channelsPerStream == 1 ? "mono" : "stereo")
+                                    + ", oversampling order " + juce::String(order));
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void compare (const CompressorPieceParameters& parameters, int channelsPerStream, double tolerance, const juce::String& mode)
+    {
+        CompressorPieceBatch<SampleType> batch;
+        batch.setParameters(parameters);
+        batch.prepare(sampleRate, blockSize, numStreams, channelsPerStream);
+
+        std::vector<std::unique_ptr<CompressorPieceDSP<SampleType>>> singles;
+
+        for( int i = 0; i < numStreams; ++i )
+        {
+            singles.push_back(std::make_unique<CompressorPieceDSP<SampleType>>());
+            singles.back()->setParameters(parameters);
+            singles.back()->prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) channelsPerStream });
+        }
+
+        //stream 0 plays, stays silent for longer than the tail so its own
+        //chain goes to sleep, then plays again; the others never stop
+        auto blocksFor = [] (double seconds) { return (int) std::ceil(seconds * sampleRate / blockSize); };
+        auto tailSeconds = singles[0]->getTailLengthSeconds();
+
+        auto silenceStart = blocksFor(0.25);
+        auto resumeBlock = silenceStart + blocksFor(tailSeconds + 0.25);
+        auto settledBlock = resumeBlock + blocksFor(2.0 * tailSeconds);
+        auto numBlocks = settledBlock + blocksFor(0.25);
+
+        juce::AudioBuffer<SampleType> batchBuffer (numStreams * channelsPerStream, blockSize);
+        juce::AudioBuffer<SampleType> singleBuffer (numStreams * channelsPerStream, blockSize);
+        juce::dsp::AudioBlock<SampleType> batchBlock (batchBuffer), singleBlock (singleBuffer);
+
+        std::vector<juce::dsp::AudioBlock<SampleType>> streams;
+        std::vector<juce::Random> generators;
+
+        for( int i = 0; i < numStreams; ++i )
+        {
+            streams.push_back(batchBlock.getSubsetChannelBlock((size_t) (i * channelsPerStream), (size_t) channelsPerStream));
+            generators.emplace_back(0x5eed + i);
+        }
+
+        double playing = 0.0, silent = 0.0, resuming = 0.0, settled = 0.0;
+        auto slept = false;
+
+        for( int b = 0; b < numBlocks; ++b )
+        {
+            auto streamSilent = b >= silenceStart && b < resumeBlock;
+
+            for( int i = 0; i < numStreams; ++i )
+            {
+                auto level = i == 0 && streamSilent ? 0.0f : 0.25f;
+
+                for( int ch = 0; ch < channelsPerStream; ++ch )
+                    for( int s = 0; s < blockSize; ++s )
+                        batchBuffer.setSample(i * channelsPerStream + ch, s, (SampleType) ((generators[(size_t) i].nextFloat() * 2.0f - 1.0f) * level));
+            }
+
+            singleBuffer.makeCopyOf(batchBuffer, true);
+
+            batch.process(streams.data(), numStreams);
+
+            for( int i = 0; i < numStreams; ++i )
+                singles[(size_t) i]->process(singleBlock.getSubsetChannelBlock((size_t) (i * channelsPerStream), (size_t) channelsPerStream));
+
+            slept = slept || singles[0]->isSleeping();
+
+            for( int i = 0; i < numStreams; ++i )
+            {
+                double difference = 0.0;
+
+                for( int ch = i * channelsPerStream; ch < (i + 1) * channelsPerStream; ++ch )
+                    for( int s = 0; s < blockSize; ++s )
+                        difference = juce::jmax(difference, (double) std::abs(batchBuffer.getSample(ch, s) - singleBuffer.getSample(ch, s)));
+
+                auto& bucket = i > 0 || b < silenceStart ? playing
+                             : b < resumeBlock ? silent
+                             : b < settledBlock ? resuming
+                             : settled;
+
+                bucket = juce::jmax(bucket, difference);
+            }
+        }
+
+        expect(slept, "stream 0's own chain never slept, " + mode);
+        expectLessOrEqual(playing, tolerance, mode);
+        expectLessOrEqual(silent, sleepTolerance, "while silent, " + mode);
+        expectLessOrEqual(settled, sleepTolerance, "after resuming, " + mode);
+
+        //a chain waking from sleep reseeds its band detectors, which the batch
+        //can't do for one stream, so this is only reported
+        logMessage("  " + mode + ": " + juce::String(resuming, 8) + " just after resuming");
+    }
+};
+
+static BatchEquivalenceTest batchEquivalenceTest;
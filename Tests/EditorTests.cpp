@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    EditorTests.cpp
+
+    Every open editor shares one decoded background image and one analyzer
+    FFT and window through SharedResources, however many instances there are,
+    and reports how long opening one more takes against the editor's
+    construction budget.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+class SharedEditorResourcesTest  : public juce::UnitTest
+{
+public:
+    SharedEditorResourcesTest() : juce::UnitTest ("Shared editor resources", "Editor") {}
+
+    void runTest() override
+    {
+        constexpr int numInstances = 4;
+
+        //held here too, so the registry outlives the editors being checked
+        juce::SharedResourcePointer<SharedResources> resources;
+        auto resourcesBefore = resources->getNumResources();
+
+        std::vector<std::unique_ptr<CompressorPieceAudioProcessor>> processors;
+        std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+
+        beginTest("Editors share one background and one FFT");
+
+        for( int i = 0; i < numInstances; ++i )
+        {
+            processors.push_back(std::make_unique<CompressorPieceAudioProcessor>());
+            editors.emplace_back(processors.back()->createEditorIfNeeded());
+            expect(editors.back() != nullptr);
+        }
+
+        expectEquals((int) resources->getUseCount<juce::Image>(0.0, 0), numInstances);
+        expectEquals((int) resources->getUseCount<SpectrumResources>(0.0, fftOrder), numInstances);
+
+        //the image and the FFT, and nothing else per editor
+        expectEquals(resources->getNumResources(), resourcesBefore + 2);
+
+        beginTest("Closing the last editor frees them");
+
+        editors.clear();
+
+        expectEquals((int) resources->getUseCount<juce::Image>(0.0, 0), 0);
+        expectEquals((int) resources->getUseCount<SpectrumResources>(0.0, fftOrder), 0);
+        expectEquals(resources->getNumResources(), resourcesBefore);
+    }
+};
+
+static SharedEditorResourcesTest sharedEditorResourcesTest;
+
+class EditorConstructionBudgetTest  : public juce::UnitTest
+{
+public:
+    EditorConstructionBudgetTest() : juce::UnitTest ("Editor construction budget", "Editor") {}
+
+    void runTest() override
+    {
+        beginTest("Opening another editor");
+
+        //the first editor decodes the shared background, which the budget leaves out
+        CompressorPieceAudioProcessor first, second;
+        std::unique_ptr<juce::AudioProcessorEditor> warmUp (first.createEditorIfNeeded());
+        expect(warmUp != nullptr);
+
+        std::unique_ptr<juce::AudioProcessorEditor> editor (second.createEditorIfNeeded());
+        auto* pluginEditor = dynamic_cast<CompressorPieceAudioProcessorEditor*>(editor.get());
+        expect(pluginEditor != nullptr);
+
+        //wall-clock time depends on the machine, its load and the build, so it
+        //is reported rather than asserted
+        if( pluginEditor != nullptr )
+            logMessage("  constructed in " + juce::String(pluginEditor->getConstructionMilliseconds(), 2)
+                       + " ms, budget " + juce::String(CompressorPieceAudioProcessorEditor::constructionBudgetMs, 0) + " ms");
+    }
+};
+
+static EditorConstructionBudgetTest editorConstructionBudgetTest;
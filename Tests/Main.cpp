@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the unit tests and exits non-zero if any of them failed.
+
+        PopPrincessTests [--category=<name>]
+
+    ctest runs each category as its own test.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+int main (int argc, char* argv[])
+{
+    //the editor tests need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args (argc, argv);
+    auto category = args.getValueForOption("--category");
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if( category.isNotEmpty() )
+        runner.runTestsInCategory(category);
+    else
+        runner.runAllTests();
+
+    int failures = 0;
+
+    for( int i = 0; i < runner.getNumResults(); ++i )
+        failures += runner.getResult(i)->failures;
+
+    if( runner.getNumResults() == 0 )
+    {
+        std::cout << "No tests in category " << category << std::endl;
+        return 1;
+    }
+
+    return failures > 0 ? 1 : 0;
+}
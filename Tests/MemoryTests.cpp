@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    MemoryTests.cpp
+
+    SharedResources must make each instance cheaper: prepares a set of
+    instances that build their own read-only data and a set attached to the
+    registry, logs the resident memory each instance added, and fails unless
+    the shared ones cost less.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+class SharedResourcesMemoryTest  : public juce::UnitTest
+{
+public:
+    SharedResourcesMemoryTest() : juce::UnitTest ("Shared resources memory", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("Sharing lowers resident memory per instance");
+
+        if( getResidentBytes() == 0 )
+        {
+            logMessage("  resident memory isn't measured on this platform");
+            return;
+        }
+
+        juce::SharedResourcePointer<SharedResources> resources;
+        std::vector<std::unique_ptr<Instance>> primer, unshared, shared;
+
+        //heap holes left by earlier tests would hide the first set's pages, so
+        //an unmeasured set fills them before either measurement
+        measure(*resources, false, primer);
+
+        auto unsharedBytes = measure(*resources, false, unshared);
+        auto sharedBytes = measure(*resources, true, shared);
+        resources->setSharing(true);
+
+        logMessage("  " + juce::String(numInstances) + " instances: " + juce::String(unsharedBytes / 1024.0, 1)
+                   + " KB resident each unshared, " + juce::String(sharedBytes / 1024.0, 1) + " KB shared");
+
+        expectLessThan(sharedBytes, unsharedBytes);
+    }
+
+private:
+    static constexpr int numInstances = 32;
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+
+    //what one plugin instance builds: a prepared float and double chain and
+    //an open editor's analyzer
+    struct Instance
+    {
+        CompressorPieceDSP<float> dsp;
+        CompressorPieceDSP<double> dspDouble;
+        std::shared_ptr<const SpectrumResources> spectrum;
+    };
+
+    //resident bytes per instance for numInstances more, all left alive so
+    //the next set can't reuse their pages
+    static double measure (SharedResources& resources, bool shouldShare, std::vector<std::unique_ptr<Instance>>& instances)
+    {
+        juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+
+        resources.setSharing(shouldShare);
+        auto before = getResidentBytes();
+
+        for( int i = 0; i < numInstances; ++i )
+        {
+            instances.push_back(std::make_unique<Instance>());
+            instances.back()->dsp.prepare(spec);
+            instances.back()->dspDouble.prepare(spec);
+            instances.back()->spectrum = SpectrumResources::get(resources, fftOrder);
+        }
+
+        return (double) (getResidentBytes() - before) / numInstances;
+    }
+
+    //the process's resident set, or 0 where it isn't measured
+    static juce::int64 getResidentBytes ()
+    {
+       #if JUCE_LINUX
+        auto fields = juce::StringArray::fromTokens(juce::File ("/proc/self/statm").loadFileAsString(), false);
+        return fields.size() > 1 ? fields[1].getLargeIntValue() * (juce::int64) sysconf(_SC_PAGESIZE) : 0;
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+        if( task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS )
+            return 0;
+
+        return (juce::int64) info.resident_size;
+       #else
+        return 0;
+       #endif
+    }
+};
+
+static SharedResourcesMemoryTest sharedResourcesMemoryTest;
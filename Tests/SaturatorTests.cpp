@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    SaturatorTests.cpp
+
+    Saturator::shape against the curve it approximates, sin(3 pi x / 4) up
+    to the knee at |x| = 2/3 and clipped beyond it.
+
+  ==============================================================================
+*/
+
+#include "Saturator.h"
+
+class SaturatorShapeTest  : public juce::UnitTest
+{
+public:
+    SaturatorShapeTest() : juce::UnitTest ("Saturator shape", "DSP") {}
+
+    void runTest() override
+    {
+        //the polynomial's own truncation error at the knee is about 5.7e-8,
+        //and float rounding adds a few ulps of 1 on top
+        beginTest("Single precision");
+        checkShape<float>(2.0e-7);
+
+        beginTest("Double precision");
+        checkShape<double>(6.0e-8);
+    }
+
+private:
+    static double reference (double x)
+    {
+        constexpr double knee = 2.0 / 3.0;
+        return std::sin(0.75 * juce::MathConstants<double>::pi * juce::jlimit(-knee, knee, x));
+    }
+
+    template <typename SampleType>
+    void checkShape (double tolerance)
+    {
+        constexpr double knee = 2.0 / 3.0;
+        constexpr int numSteps = 400000;
+
+        juce::Array<double> points;
+
+        for( int i = 0; i <= numSteps; ++i )
+            points.add(-2.0 + 4.0 * i / numSteps);
+
+        //densely either side of the knee, where the sine flattens into the clip
+        for( auto side : { -1.0, 1.0 } )
+            for( int i = -1000; i <= 1000; ++i )
+                points.add(side * (knee + i * 1.0e-6));
+
+        double maxError = 0.0, worstInput = 0.0;
+
+        for( auto point : points )
+        {
+            auto x = static_cast<SampleType> (point);
+            auto error = std::abs((double) Saturator<SampleType>::shape(x) - reference((double) x));
+
+            if( error > maxError )
+            {
+                maxError = error;
+                worstInput = (double) x;
+            }
+        }
+
+        logMessage("max error " + juce::String(maxError) + " at " + juce::String(worstInput));
+        expectLessOrEqual(maxError, tolerance, "max error at x = " + juce::String(worstInput));
+
+        //beyond the knee the output is exactly the knee's
+        auto atKnee = Saturator<SampleType>::shape(static_cast<SampleType> (knee));
+        expectEquals(Saturator<SampleType>::shape(static_cast<SampleType> (2)), atKnee);
+        expectEquals(Saturator<SampleType>::shape(static_cast<SampleType> (-2)), -atKnee);
+    }
+};
+
+static SaturatorShapeTest saturatorShapeTest;
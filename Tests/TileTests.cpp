@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    TileTests.cpp
+
+    The pipeline tile size must not change the chain's output at all: runs
+    the same input through whole blocks and through several tile sizes, in
+    every oversampling mode, and fails on any difference.
+
+  ==============================================================================
+*/
+
+#include "CompressorPieceDSP.h"
+
+class TileEquivalenceTest  : public juce::UnitTest
+{
+public:
+    TileEquivalenceTest() : juce::UnitTest ("Pipeline tiles", "DSP") {}
+
+    void runTest() override
+    {
+        beginTest("Single precision");
+        runEveryMode<float>();
+
+        beginTest("Double precision");
+        runEveryMode<double>();
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 4096;
+    static constexpr int numBlocks = 24;
+    static constexpr int numChannels = 3;
+
+    template <typename SampleType>
+    void runEveryMode ()
+    {
+        for( int order = 0; order < 4; ++order )
+        {
+            for( auto linear : { false, true } )
+            {
+                CompressorPieceParameters parameters;
+                parameters.amount = 60.0f;
+                parameters.threshold = -24.0f;
+                parameters.makeup = 3.0f;
+                parameters.oversamplingOrder = order;
+                parameters.linearPhase = linear;
+                parameters.bandLink = DetectorLink::maximum;
+                parameters.limiter = true;
+
+                auto reference = render<SampleType>(parameters, 0);
+
+                //a size that doesn't divide the block leaves a short last tile
+                for( auto tileSize : { 64, 128, 256, 1000 } )
+                {
+                    auto output = render<SampleType>(parameters, tileSize);
+                    auto mismatches = 0;
+
+                    for( int ch = 0; ch < numChannels; ++ch )
+                        for( int i = 0; i < output.getNumSamples(); ++i )
+                            if( output.getSample(ch, i) != reference.getSample(ch, i) )
+                                ++mismatches;
+
+                    expectEquals(mismatches, 0, "tile " + juce::String(tileSize) + ", oversampling order " + juce::String(order)
+                                                + (linear ? ", linear phase" : ", minimum phase"));
+                }
+            }
+        }
+    }
+
+    //loud and quiet stretches, so states pass through the flush-to-zero range
+    template <typename SampleType>
+    static juce::AudioBuffer<SampleType> render (const CompressorPieceParameters& parameters, int tileSize)
+    {
+        CompressorPieceDSP<SampleType> dsp;
+        dsp.setParameters(parameters);
+        dsp.setTileSize(tileSize);
+        dsp.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+        juce::AudioBuffer<SampleType> output (numChannels, numBlocks * blockSize);
+        juce::Random random (0x5eed);
+
+        for( int b = 0; b < numBlocks; ++b )
+        {
+            auto level = b % 4 == 3 ? 1.0e-7f : (b % 2 == 0 ? 0.5f : 0.05f);
+
+            for( int ch = 0; ch < numChannels; ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    output.setSample(ch, b * blockSize + i, (SampleType) ((random.nextFloat() * 2.0f - 1.0f) * level));
+
+            dsp.process(juce::dsp::AudioBlock<SampleType> (output).getSubBlock((size_t) (b * blockSize), blockSize));
+        }
+
+        return output;
+    }
+};
+
+static TileEquivalenceTest tileEquivalenceTest;
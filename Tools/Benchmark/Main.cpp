@@ -0,0 +1,719 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Times every stage of the chain, and the chain as a whole, across block
+    sizes, sample rates, channel counts and detector link modes, and prints
+    the results as JSON.
+
+  ==============================================================================
+*/
+
+#include "CompressorPieceDSP.h"
+#include "CompressorPieceBatch.h"
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+namespace
+{
+    //settings every run uses, roughly a mid-way Amount on a hot signal
+    constexpr float benchAmount = 50.0f;
+    constexpr float benchThreshold = -12.0f;
+    constexpr float benchMakeup = 3.0f;
+
+    struct BenchOptions
+    {
+        double secondsPerRun { 1.0 };
+        int repeats { 3 };
+        juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        juce::Array<int> channelCounts { 1, 2, 12 };
+        juce::StringArray links { "off", "max" };
+        juce::StringArray stages;
+    };
+
+    //==============================================================================
+    /**
+        Every stage of CompressorPieceDSP as a separate object, set up the way
+        CompressorPieceDSP::prepare sets them up, so each can be timed alone.
+        Only the stage call itself is timed; refilling its input is not.
+    */
+    struct Fixture
+    {
+        Fixture (double sampleRate, int blockSize, int numChannels, DetectorLink link)
+            : input (numChannels, blockSize),
+              work (numChannels, blockSize),
+              bandStorage (3 * numChannels, blockSize),
+              bandInput (3 * numChannels, blockSize)
+        {
+            spec.sampleRate = sampleRate;
+            spec.maximumBlockSize = (juce::uint32) blockSize;
+            spec.numChannels = (juce::uint32) numChannels;
+
+            //white noise at about -12 dBFS, the same every run
+            juce::Random random (0x5eed);
+
+            for( int ch = 0; ch < numChannels; ++ch )
+                for( int i = 0; i < blockSize; ++i )
+                    input.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+            auto amountFraction = benchAmount / 100.0f;
+
+            saturator.prepare(spec);
+            saturator.setDriveDecibels(amountFraction * 35.0f);
+            saturator.setOutputGainDecibels(amountFraction * -35.0f);
+
+            //the QualityGovernor's cheapSaturator tier
+            cheapSaturator.prepare(spec);
+            cheapSaturator.setDriveDecibels(amountFraction * 35.0f);
+            cheapSaturator.setOutputGainDecibels(amountFraction * -35.0f);
+            cheapSaturator.setCheapCurveAmount(1.0f);
+            cheapSaturator.reset();
+
+            auto& glue = chain1.get<0>();
+            glue.setDetectorLink(link);
+            glue.setRatio(amountFraction * (4.0f - 1.15f) + 1.15f);
+            glue.setAttack(1.0f);
+            glue.setRelease(30.0f);
+            glue.setThreshold(benchThreshold);
+            chain1.get<1>().setGainDecibels(benchMakeup);
+            chain1.prepare(spec);
+
+            crossover.prepare(spec);
+            crossover.setCrossoverFrequencies(88.3f, 2500.0f);
+
+            using MBComp = MultibandCompressor<float>;
+            compressors.prepare(spec);
+            compressors.setDetectorLink(link);
+
+            for( size_t band = 0; band < MBComp::numBands; ++band )
+            {
+                compressors.setRatio(band, band == MBComp::highBand ? 100.0f : 66.7f);
+                compressors.setRelease(band, 282.0f);
+                compressors.setInputGainDecibels(band, 5.2f);
+            }
+
+            compressors.setAttack(MBComp::lowBand, 47.8f);
+            compressors.setAttack(MBComp::midBand, 22.4f);
+            compressors.setAttack(MBComp::highBand, 13.5f);
+            compressors.setThreshold(MBComp::lowBand, -33.8f);
+            compressors.setThreshold(MBComp::midBand, -30.2f);
+            compressors.setThreshold(MBComp::highBand, -35.5f);
+            compressors.setOutputGainDecibels(MBComp::lowBand, 10.3f);
+            compressors.setOutputGainDecibels(MBComp::midBand, 5.7f);
+            compressors.setOutputGainDecibels(MBComp::highBand, 10.3f);
+
+            //the band path MultibandCompressor replaced, with the same presets:
+            //per band an input gain, a juce::dsp::Compressor and an output gain,
+            //one after the other; it has no detector link
+            const float baselineRatios[] { 66.7f, 66.7f, 100.0f };
+            const float baselineAttacks[] { 47.8f, 22.4f, 13.5f };
+            const float baselineThresholds[] { -33.8f, -30.2f, -35.5f };
+            const float baselineOutputGains[] { 10.3f, 5.7f, 10.3f };
+
+            for( size_t band = 0; band < baselineCompressors.size(); ++band )
+            {
+                baselineCompressors[band].prepare(spec);
+                baselineCompressors[band].setRatio(baselineRatios[band]);
+                baselineCompressors[band].setAttack(baselineAttacks[band]);
+                baselineCompressors[band].setRelease(282.0f);
+                baselineCompressors[band].setThreshold(baselineThresholds[band]);
+
+                baselineInGains[band].prepare(spec);
+                baselineInGains[band].setGainDecibels(5.2f);
+                baselineOutGains[band].prepare(spec);
+                baselineOutGains[band].setGainDecibels(baselineOutputGains[band]);
+            }
+
+            *shelf.state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, 2500.0f, 0.71f,
+                                                                               juce::Decibels::decibelsToGain(amountFraction * -0.87f));
+            shelf.prepare(spec);
+
+            limiter.prepare(spec);
+            limiter.setCeilingDecibels(-6.0f);
+
+            full.setAmount(benchAmount);
+            full.setThreshold(benchThreshold);
+            full.setMakeup(benchMakeup);
+            full.setGlueLink(link);
+            full.setBandLink(link);
+            full.prepare(spec);
+
+            //the band compressors and band sum get real crossover output
+            juce::dsp::AudioBlock<float> bandInputBlock (bandInput);
+            auto bandInputs = getBands(bandInputBlock);
+            crossover.process(juce::dsp::AudioBlock<float> (input), bandInputs);
+            crossover.reset();
+        }
+
+        std::array<juce::dsp::AudioBlock<float>, 3> getBands (juce::dsp::AudioBlock<float>& storage) const
+        {
+            std::array<juce::dsp::AudioBlock<float>, 3> bands;
+
+            for( size_t i = 0; i < bands.size(); ++i )
+                bands[i] = storage.getSubsetChannelBlock(i * spec.numChannels, spec.numChannels);
+
+            return bands;
+        }
+
+        void refill (juce::AudioBuffer<float>& destination, const juce::AudioBuffer<float>& source)
+        {
+            for( int ch = 0; ch < destination.getNumChannels(); ++ch )
+                destination.copyFrom(ch, 0, source, ch, 0, destination.getNumSamples());
+        }
+
+        /** Best of repeats, in seconds of processing per block. */
+        template <typename Prepare, typename Process>
+        double time (int numBlocks, int repeats, Prepare&& prepareBlock, Process&& processBlock)
+        {
+            auto best = std::numeric_limits<double>::max();
+
+            for( int r = 0; r < repeats; ++r )
+            {
+                juce::int64 ticks = 0;
+
+                for( int b = 0; b < numBlocks; ++b )
+                {
+                    prepareBlock();
+                    auto start = juce::Time::getHighResolutionTicks();
+                    processBlock();
+                    ticks += juce::Time::getHighResolutionTicks() - start;
+                }
+
+                best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(ticks) / numBlocks);
+            }
+
+            return best;
+        }
+
+        /** Seconds per block for the named stage. */
+        double run (const juce::String& stage, int numBlocks, int repeats)
+        {
+            juce::dsp::AudioBlock<float> block (work);
+            juce::dsp::AudioBlock<float> bandBlock (bandStorage);
+            auto bands = getBands(bandBlock);
+            auto noRefill = [] {};
+            auto refillWork = [this] { refill(work, input); };
+
+            if( stage == "saturator" )
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    juce::dsp::ProcessContextReplacing<float> context (block);
+                    saturator.process(context);
+                    chain1.process(context);
+                });
+
+            if( stage == "cheapSaturator" )
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    juce::dsp::ProcessContextReplacing<float> context (block);
+                    cheapSaturator.process(context);
+                    chain1.process(context);
+                });
+
+            if( stage == "glue" )
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    chain1.process(juce::dsp::ProcessContextReplacing<float> (block));
+                });
+
+            if( stage == "crossover" )
+                return time(numBlocks, repeats, noRefill, [&]
+                {
+                    crossover.process(juce::dsp::AudioBlock<float> (input), bands);
+                });
+
+            if( stage == "bandCompressors" )
+                return time(numBlocks, repeats, [this] { refill(bandStorage, bandInput); }, [&]
+                {
+                    compressors.process(bands);
+                });
+
+            if( stage == "bandCompressorsBaseline" )
+                return time(numBlocks, repeats, [this] { refill(bandStorage, bandInput); }, [&]
+                {
+                    for( size_t band = 0; band < bands.size(); ++band )
+                    {
+                        juce::dsp::ProcessContextReplacing<float> context (bands[band]);
+                        baselineInGains[band].process(context);
+                        baselineCompressors[band].process(context);
+                        baselineOutGains[band].process(context);
+                    }
+                });
+
+            if( stage == "bandSum" )
+            {
+                juce::dsp::AudioBlock<float> bandInputBlock (bandInput);
+                auto sources = getBands(bandInputBlock);
+                auto ottMix = benchAmount / 100.0f * 0.75f;
+
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    for( auto& source : sources )
+                        block.addProductOf(source, ottMix);
+                });
+            }
+
+            if( stage == "shelf" )
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    shelf.process(juce::dsp::ProcessContextReplacing<float> (block));
+                });
+
+            if( stage == "limiter" )
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    limiter.process(juce::dsp::ProcessContextReplacing<float> (block));
+                });
+
+            if( stage == "fullChain" )
+                return time(numBlocks, repeats, refillWork, [&]
+                {
+                    full.process(block);
+                });
+
+            jassertfalse;
+            return 0.0;
+        }
+
+        juce::dsp::ProcessSpec spec;
+        juce::AudioBuffer<float> input, work, bandStorage, bandInput;
+
+        Saturator<float> saturator, cheapSaturator;
+        juce::dsp::ProcessorChain<GlueCompressor<float>, juce::dsp::Gain<float>> chain1;
+        ThreeBandCrossover<float> crossover;
+        MultibandCompressor<float> compressors;
+        std::array<juce::dsp::Compressor<float>, 3> baselineCompressors;
+        std::array<juce::dsp::Gain<float>, 3> baselineInGains, baselineOutGains;
+        juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> shelf;
+        LookaheadLimiter<float> limiter;
+        CompressorPieceDSP<float> full;
+    };
+
+    const juce::StringArray allStages { "saturator", "cheapSaturator", "glue", "crossover", "bandCompressors", "bandCompressorsBaseline", "bandSum", "shelf", "limiter", "fullChain" };
+    const juce::StringArray allLinks { "off", "max", "sum" };
+
+    //==============================================================================
+    void printUsage (const juce::String& name)
+    {
+        std::cout << "Usage: " << name << " [options]" << std::endl
+                  << std::endl
+                  << "  --output=<file>         Write the JSON here instead of stdout" << std::endl
+                  << "  --seconds=<s>           Audio processed per measurement (default 1)" << std::endl
+                  << "  --repeats=<n>           Measurements per point, best is kept (default 3)" << std::endl
+                  << "  --stages=<a,b,...>      Only these of " << allStages.joinIntoString(", ") << std::endl
+                  << "  --links=<a,b,...>       Detector link modes, of off, max, sum (default off,max)" << std::endl
+                  << "  --quick                 64/512/4096 samples, 48/96 kHz, stereo only" << std::endl
+                  << "  --batch=<n>             Also run n stereo streams through CompressorPieceBatch" << std::endl
+                  << "                          and through n separate chains, and compare" << std::endl
+                  << "  --tiles=<a,b,...>       Also time the full chain with these pipeline tile" << std::endl
+                  << "                          sizes against whole blocks, and compare" << std::endl
+                  << "  --instances=<n>         Also report resident memory per instance for n" << std::endl
+                  << "                          instances, with and without SharedResources" << std::endl;
+    }
+
+    //==============================================================================
+    /** The process's resident set, or 0 where it isn't measured. */
+    juce::int64 getResidentBytes ()
+    {
+       #if JUCE_LINUX
+        auto fields = juce::StringArray::fromTokens(juce::File ("/proc/self/statm").loadFileAsString(), false);
+        return fields.size() > 1 ? fields[1].getLargeIntValue() * (juce::int64) sysconf(_SC_PAGESIZE) : 0;
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+        if( task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS )
+            return 0;
+
+        return (juce::int64) info.resident_size;
+       #else
+        return 0;
+       #endif
+    }
+
+    /** Resident memory per instance for n plugin instances, each a prepared
+        float and double chain plus an open editor's analyzer, first with
+        every instance building its own read-only data and then attached to
+        SharedResources. Both sets stay alive until the end, so the second
+        can't just reuse pages the first has freed.
+    */
+    juce::var compareInstances (int numInstances, double sampleRate, int blockSize)
+    {
+        //the editor's analyzer size, from PluginEditor.h
+        constexpr int analyzerFftOrder = 11;
+
+        struct Instance
+        {
+            CompressorPieceDSP<float> dsp;
+            CompressorPieceDSP<double> dspDouble;
+            std::shared_ptr<const SpectrumResources> spectrum;
+        };
+
+        juce::SharedResourcePointer<SharedResources> resources;
+        juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+        std::vector<std::unique_ptr<Instance>> unshared, shared;
+
+        auto measure = [&] (bool shouldShare, std::vector<std::unique_ptr<Instance>>& instances)
+        {
+            resources->setSharing(shouldShare);
+            auto before = getResidentBytes();
+
+            for( int i = 0; i < numInstances; ++i )
+            {
+                instances.push_back(std::make_unique<Instance>());
+                instances.back()->dsp.prepare(spec);
+                instances.back()->dspDouble.prepare(spec);
+                instances.back()->spectrum = SpectrumResources::get(*resources, analyzerFftOrder);
+            }
+
+            return (double) (getResidentBytes() - before) / numInstances;
+        };
+
+        auto unsharedBytes = measure(false, unshared);
+        auto sharedBytes = measure(true, shared);
+        resources->setSharing(true);
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("instances", numInstances);
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("blockSize", blockSize);
+        result->setProperty("unsharedBytesPerInstance", unsharedBytes);
+        result->setProperty("sharedBytesPerInstance", sharedBytes);
+        result->setProperty("sharedResources", resources->getNumResources());
+
+        std::cerr << numInstances << " instances: " << juce::String(unsharedBytes / 1024.0, 1) << " KB resident each unshared, "
+                  << juce::String(sharedBytes / 1024.0, 1) << " KB shared" << std::endl;
+
+        return result;
+    }
+
+    //==============================================================================
+    /** Times the full chain on large stereo blocks at each pipeline tile size,
+        against one processing whole blocks, and reports the largest
+        difference from it. The fastest size is the one to use as the default.
+    */
+    juce::var compareTiles (const juce::Array<int>& tileSizes, double sampleRate, int blockSize, double seconds)
+    {
+        constexpr int numChannels = 2;
+
+        juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels };
+        auto numBlocks = juce::jmax(1, juce::roundToInt(seconds * sampleRate / blockSize));
+
+        //whole blocks first, so the others have something to compare against
+        juce::Array<int> sizes { 0 };
+        sizes.addArray(tileSizes);
+
+        juce::AudioBuffer<float> reference (numChannels, numBlocks * blockSize), buffer (numChannels, blockSize);
+        juce::Array<juce::var> runs;
+        auto bestSize = 0;
+        auto bestSeconds = std::numeric_limits<double>::max();
+
+        for( auto tileSize : sizes )
+        {
+            CompressorPieceDSP<float> dsp;
+            dsp.setAmount(benchAmount);
+            dsp.setThreshold(benchThreshold);
+            dsp.setMakeup(benchMakeup);
+            dsp.setTileSize(tileSize);
+            dsp.prepare(spec);
+
+            juce::Random random (0x5eed);
+            juce::dsp::AudioBlock<float> block (buffer);
+            juce::int64 ticks = 0;
+            float maxDifference = 0.0f;
+
+            for( int b = 0; b < numBlocks; ++b )
+            {
+                for( int ch = 0; ch < numChannels; ++ch )
+                    for( int s = 0; s < blockSize; ++s )
+                        buffer.setSample(ch, s, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                dsp.process(block);
+                ticks += juce::Time::getHighResolutionTicks() - start;
+
+                for( int ch = 0; ch < numChannels; ++ch )
+                {
+                    if( tileSize == 0 )
+                        reference.copyFrom(ch, b * blockSize, buffer, ch, 0, blockSize);
+                    else
+                        for( int s = 0; s < blockSize; ++s )
+                            maxDifference = juce::jmax(maxDifference, std::abs(buffer.getSample(ch, s) - reference.getSample(ch, b * blockSize + s)));
+                }
+            }
+
+            auto runSeconds = juce::Time::highResolutionTicksToSeconds(ticks);
+            auto nsPerSample = runSeconds * 1.0e9 / ((double) numBlocks * blockSize);
+
+            if( runSeconds < bestSeconds )
+            {
+                bestSeconds = runSeconds;
+                bestSize = tileSize;
+            }
+
+            auto* run = new juce::DynamicObject();
+            run->setProperty("tileSize", tileSize);
+            run->setProperty("nsPerSample", nsPerSample);
+            run->setProperty("maxDifference", maxDifference);
+            runs.add(run);
+
+            std::cerr << "tile " << tileSize << ": " << juce::String(nsPerSample, 2)
+                      << " ns/sample, max difference " << maxDifference << std::endl;
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("blockSize", blockSize);
+        result->setProperty("channels", numChannels);
+        result->setProperty("runs", runs);
+        result->setProperty("fastest", bestSize);
+        return result;
+    }
+
+    //==============================================================================
+    /** Times n stereo noise streams through one CompressorPieceBatch and through
+        n CompressorPieceDSPs, and reports the largest difference between them.
+    */
+    juce::var compareBatch (int numStreams, double sampleRate, int blockSize, double seconds)
+    {
+        constexpr int channelsPerStream = 2;
+
+        CompressorPieceParameters parameters;
+        parameters.amount = benchAmount;
+        parameters.threshold = benchThreshold;
+        parameters.makeup = benchMakeup;
+
+        juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, (juce::uint32) channelsPerStream };
+
+        CompressorPieceBatch<float> batch;
+        batch.setParameters(parameters);
+        batch.prepare(sampleRate, blockSize, numStreams, channelsPerStream);
+
+        std::vector<std::unique_ptr<CompressorPieceDSP<float>>> singles;
+
+        for( int i = 0; i < numStreams; ++i )
+        {
+            singles.push_back(std::make_unique<CompressorPieceDSP<float>>());
+            singles.back()->setParameters(parameters);
+            singles.back()->prepare(spec);
+        }
+
+        //a different noise seed per stream, so no two lanes see the same signal
+        juce::AudioBuffer<float> batchBuffer (numStreams * channelsPerStream, blockSize);
+        juce::AudioBuffer<float> singleBuffer (numStreams * channelsPerStream, blockSize);
+        std::vector<juce::Random> generators;
+
+        for( int i = 0; i < numStreams; ++i )
+            generators.emplace_back(0x5eed + i);
+
+        std::vector<juce::dsp::AudioBlock<float>> streams;
+        juce::dsp::AudioBlock<float> batchBlock (batchBuffer), singleBlock (singleBuffer);
+
+        for( int i = 0; i < numStreams; ++i )
+            streams.push_back(batchBlock.getSubsetChannelBlock((size_t) (i * channelsPerStream), channelsPerStream));
+
+        auto numBlocks = juce::jmax(1, juce::roundToInt(seconds * sampleRate / blockSize));
+        juce::int64 batchTicks = 0, singleTicks = 0;
+        float maxDifference = 0.0f;
+
+        for( int b = 0; b < numBlocks; ++b )
+        {
+            for( int i = 0; i < numStreams; ++i )
+                for( int ch = 0; ch < channelsPerStream; ++ch )
+                    for( int s = 0; s < blockSize; ++s )
+                        batchBuffer.setSample(i * channelsPerStream + ch, s, (generators[(size_t) i].nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+            singleBuffer.makeCopyOf(batchBuffer, true);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            batch.process(streams.data(), numStreams);
+            batchTicks += juce::Time::getHighResolutionTicks() - start;
+
+            start = juce::Time::getHighResolutionTicks();
+            for( int i = 0; i < numStreams; ++i )
+                singles[(size_t) i]->process(singleBlock.getSubsetChannelBlock((size_t) (i * channelsPerStream), channelsPerStream));
+            singleTicks += juce::Time::getHighResolutionTicks() - start;
+
+            for( int ch = 0; ch < batchBuffer.getNumChannels(); ++ch )
+                for( int s = 0; s < blockSize; ++s )
+                    maxDifference = juce::jmax(maxDifference, std::abs(batchBuffer.getSample(ch, s) - singleBuffer.getSample(ch, s)));
+        }
+
+        auto streamSamples = (double) numBlocks * blockSize * numStreams;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("streams", numStreams);
+        result->setProperty("channelsPerStream", channelsPerStream);
+        result->setProperty("sampleRate", sampleRate);
+        result->setProperty("blockSize", blockSize);
+        result->setProperty("batchNsPerStreamSample", juce::Time::highResolutionTicksToSeconds(batchTicks) * 1.0e9 / streamSamples);
+        result->setProperty("singleNsPerStreamSample", juce::Time::highResolutionTicksToSeconds(singleTicks) * 1.0e9 / streamSamples);
+        result->setProperty("maxDifference", maxDifference);
+
+        std::cerr << "batch of " << numStreams << ": " << juce::String(juce::Time::highResolutionTicksToSeconds(batchTicks) * 1.0e9 / streamSamples, 2)
+                  << " ns/stream sample vs " << juce::String(juce::Time::highResolutionTicksToSeconds(singleTicks) * 1.0e9 / streamSamples, 2)
+                  << " separately, max difference " << maxDifference << std::endl;
+
+        return result;
+    }
+
+    juce::var getSystemInfo ()
+    {
+        auto* info = new juce::DynamicObject();
+        info->setProperty("cpu", juce::SystemStats::getCpuModel());
+        info->setProperty("cpus", juce::SystemStats::getNumCpus());
+        info->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        info->setProperty("juce", juce::SystemStats::getJUCEVersion());
+        info->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+       #if JUCE_DEBUG
+        info->setProperty("build", "debug");
+       #else
+        info->setProperty("build", "release");
+       #endif
+        return info;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if( args.containsOption("--help|-h") )
+    {
+        printUsage(args.executableName);
+        return 0;
+    }
+
+    BenchOptions options;
+
+    if( args.containsOption("--seconds") )
+        options.secondsPerRun = juce::jmax(0.01, args.getValueForOption("--seconds").getDoubleValue());
+
+    if( args.containsOption("--repeats") )
+        options.repeats = juce::jmax(1, args.getValueForOption("--repeats").getIntValue());
+
+    if( args.containsOption("--quick") )
+    {
+        options.blockSizes = { 64, 512, 4096 };
+        options.sampleRates = { 48000.0, 96000.0 };
+        options.channelCounts = { 2 };
+    }
+
+    options.stages = args.containsOption("--stages")
+                         ? juce::StringArray::fromTokens(args.getValueForOption("--stages"), ",", {})
+                         : allStages;
+
+    for( auto& stage : options.stages )
+    {
+        if( ! allStages.contains(stage) )
+        {
+            std::cerr << "Unknown stage " << stage << std::endl;
+            return 1;
+        }
+    }
+
+    if( args.containsOption("--links") )
+        options.links = juce::StringArray::fromTokens(args.getValueForOption("--links"), ",", {});
+
+    for( auto& link : options.links )
+    {
+        if( ! allLinks.contains(link) )
+        {
+            std::cerr << "Unknown link mode " << link << std::endl;
+            return 1;
+        }
+    }
+
+    juce::ScopedNoDenormals noDenormals;
+    juce::Array<juce::var> results;
+
+    for( auto numChannels : options.channelCounts )
+    {
+        for( auto sampleRate : options.sampleRates )
+        {
+            for( auto blockSize : options.blockSizes )
+            {
+                for( auto& link : options.links )
+                {
+                    //linking only changes anything with more than one channel
+                    if( numChannels == 1 && link != options.links[0] )
+                        continue;
+
+                    Fixture fixture (sampleRate, blockSize, numChannels, (DetectorLink) allLinks.indexOf(link));
+                    auto numBlocks = juce::jmax(1, juce::roundToInt(options.secondsPerRun * sampleRate / blockSize));
+                    auto blockSeconds = blockSize / sampleRate;
+
+                    for( auto& stage : options.stages )
+                    {
+                        auto seconds = fixture.run(stage, numBlocks, options.repeats);
+
+                        //per sample frame, i.e. all channels of one sample
+                        auto* result = new juce::DynamicObject();
+                        result->setProperty("stage", stage);
+                        result->setProperty("sampleRate", sampleRate);
+                        result->setProperty("blockSize", blockSize);
+                        result->setProperty("channels", numChannels);
+                        result->setProperty("link", link);
+                        result->setProperty("nsPerSample", seconds * 1.0e9 / blockSize);
+                        result->setProperty("realtimeFactor", seconds > 0.0 ? blockSeconds / seconds : 0.0);
+                        results.add(result);
+
+                        std::cerr << stage << " " << sampleRate << " Hz " << blockSize << " x " << numChannels << " link " << link << ": "
+                                  << juce::String(seconds * 1.0e9 / blockSize, 2) << " ns/sample" << std::endl;
+                    }
+                }
+            }
+        }
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("system", getSystemInfo());
+    root->setProperty("secondsPerRun", options.secondsPerRun);
+    root->setProperty("repeats", options.repeats);
+    root->setProperty("results", results);
+
+    if( args.containsOption("--batch") )
+        root->setProperty("batch", compareBatch(juce::jmax(1, args.getValueForOption("--batch").getIntValue()),
+                                                48000.0, 512, options.secondsPerRun));
+
+    if( args.containsOption("--instances") )
+        root->setProperty("instances", compareInstances(juce::jmax(1, args.getValueForOption("--instances").getIntValue()),
+                                                        48000.0, 512));
+
+    if( args.containsOption("--tiles") )
+    {
+        juce::Array<int> tileSizes;
+
+        for( auto& size : juce::StringArray::fromTokens(args.getValueForOption("--tiles"), ",", {}) )
+            if( size.getIntValue() > 0 )
+                tileSizes.add(size.getIntValue());
+
+        root->setProperty("tiles", compareTiles(tileSizes, 48000.0, 4096, options.secondsPerRun));
+    }
+
+    auto json = juce::JSON::toString(juce::var (root));
+
+    if( args.containsOption("--output") )
+    {
+        auto file = args.getFileForOption("--output");
+
+        if( ! file.replaceWithText(json) )
+        {
+            std::cerr << "Can't write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return 0;
+}
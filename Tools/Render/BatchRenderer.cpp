@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+#include <thread>
+
+namespace
+{
+    juce::Result readSettings (const juce::var& object, RenderSettings& settings)
+    {
+        auto readFloat = [&object] (const juce::Identifier& name, float& value, float minValue, float maxValue)
+        {
+            if( object.hasProperty(name) )
+                value = juce::jlimit(minValue, maxValue, (float) object[name]);
+        };
+
+        readFloat("amount", settings.parameters.amount, 0.0f, 100.0f);
+        readFloat("threshold", settings.parameters.threshold, -70.0f, 6.0f);
+        readFloat("makeup", settings.parameters.makeup, 0.0f, 20.0f);
+        readFloat("ceiling", settings.parameters.ceiling, -12.0f, 0.0f);
+        readFloat("lookahead", settings.parameters.lookahead, 0.5f, 5.0f);
+
+        if( object.hasProperty("linearPhase") )
+            settings.parameters.linearPhase = (bool) object["linearPhase"];
+
+        if( object.hasProperty("limiter") )
+            settings.parameters.limiter = (bool) object["limiter"];
+
+        for( auto* name : { "glueLink", "bandLink" } )
+        {
+            if( ! object.hasProperty(name) )
+                continue;
+
+            auto link = juce::StringArray { "off", "max", "sum" }.indexOf(object[name].toString());
+
+            if( link < 0 )
+                return juce::Result::fail(juce::String(name) + " must be \"off\", \"max\" or \"sum\"");
+
+            (juce::String(name) == "glueLink" ? settings.parameters.glueLink : settings.parameters.bandLink) = (DetectorLink) link;
+        }
+
+        if( object.hasProperty("oversampling") )
+        {
+            auto order = juce::Array<int> { 1, 2, 4, 8 }.indexOf((int) object["oversampling"]);
+
+            if( order < 0 )
+                return juce::Result::fail("oversampling must be 1, 2, 4 or 8");
+
+            settings.parameters.oversamplingOrder = order;
+        }
+
+        if( object.hasProperty("block") )
+        {
+            settings.blockSize = (int) object["block"];
+
+            if( settings.blockSize < 1 )
+                return juce::Result::fail("block must be a positive number of samples");
+        }
+
+        return juce::Result::ok();
+    }
+}
+
+//==============================================================================
+juce::Result BatchRenderer::parseManifest (const juce::File& manifest,
+                                           const RenderSettings& defaults,
+                                           std::vector<BatchJob>& jobs)
+{
+    if( ! manifest.existsAsFile() )
+        return juce::Result::fail("Can't find " + manifest.getFullPathName());
+
+    juce::var root;
+    auto parsed = juce::JSON::parse(manifest.loadFileAsString(), root);
+
+    if( parsed.failed() )
+        return juce::Result::fail(manifest.getFullPathName() + ": " + parsed.getErrorMessage());
+
+    auto manifestDefaults = defaults;
+    auto defaultsResult = readSettings(root["defaults"], manifestDefaults);
+
+    if( defaultsResult.failed() )
+        return juce::Result::fail(manifest.getFullPathName() + ": defaults: " + defaultsResult.getErrorMessage());
+
+    auto* entries = root["jobs"].getArray();
+
+    if( entries == nullptr )
+        return juce::Result::fail(manifest.getFullPathName() + ": expected a \"jobs\" array");
+
+    auto folder = manifest.getParentDirectory();
+
+    for( int i = 0; i < entries->size(); ++i )
+    {
+        const auto& entry = entries->getReference(i);
+        auto input = entry["input"].toString();
+        auto output = entry["output"].toString();
+
+        if( input.isEmpty() || output.isEmpty() )
+            return juce::Result::fail(manifest.getFullPathName() + ": job " + juce::String(i) + " needs an input and an output");
+
+        BatchJob job;
+        job.input = folder.getChildFile(input);
+        job.output = folder.getChildFile(output);
+        job.settings = manifestDefaults;
+
+        auto jobResult = readSettings(entry, job.settings);
+
+        if( jobResult.failed() )
+            return juce::Result::fail(manifest.getFullPathName() + ": job " + juce::String(i) + ": " + jobResult.getErrorMessage());
+
+        jobs.push_back(job);
+    }
+
+    return juce::Result::ok();
+}
+
+std::vector<BatchResult> BatchRenderer::run (const std::vector<BatchJob>& jobs, int numThreads)
+{
+    std::vector<BatchResult> results (jobs.size());
+
+    if( numThreads <= 0 )
+        numThreads = juce::SystemStats::getNumCpus();
+
+    numThreads = juce::jlimit(1, juce::jmax(1, (int) jobs.size()), numThreads);
+
+    std::atomic<size_t> nextJob { 0 };
+
+    auto worker = [&]
+    {
+        OfflineRenderer renderer;
+        CompressorPieceDSP<float> dsp;
+
+        //every job writes only its own slot, so results needs no lock
+        for( auto index = nextJob++; index < jobs.size(); index = nextJob++ )
+        {
+            const auto& job = jobs[index];
+            auto& result = results[index];
+            result.result = renderer.render(dsp, job.input, job.output, job.settings, &result.stats);
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for( int i = 1; i < numThreads; ++i )
+        threads.emplace_back(worker);
+
+    //the calling thread is a worker too
+    worker();
+
+    for( auto& thread : threads )
+        thread.join();
+
+    return results;
+}
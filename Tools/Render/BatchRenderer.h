@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OfflineRenderer.h"
+
+//==============================================================================
+/** One file to render and the settings to render it with. */
+struct BatchJob
+{
+    juce::File input, output;
+    RenderSettings settings;
+};
+
+/** How one BatchJob went. */
+struct BatchResult
+{
+    juce::Result result { juce::Result::ok() };
+    RenderStats stats;
+};
+
+//==============================================================================
+/**
+    Renders many files at once, one per worker thread.
+
+    Each worker owns an OfflineRenderer and a CompressorPieceDSP for its whole
+    life and re-prepares them for every file it picks up, so nothing is built
+    per job beyond the reader and writer. Idle workers take the next unclaimed
+    job from a shared counter, which keeps every core busy until the list
+    runs out however uneven the file lengths are.
+*/
+class BatchRenderer
+{
+public:
+    /** Reads a JSON manifest of the form
+
+            {
+              "defaults": { "amount": 40, "threshold": -12, "makeup": 3 },
+              "jobs": [
+                { "input": "stems/vox.wav", "output": "out/vox.wav" },
+                { "input": "stems/gtr.aif", "output": "out/gtr.aif", "amount": 70, "oversampling": 4 }
+              ]
+            }
+
+        Each job may override any of amount, threshold, makeup, oversampling
+        (1, 2, 4 or 8), linearPhase, glueLink and bandLink ("off", "max" or
+        "sum"), limiter, ceiling, lookahead and block. Relative paths are
+        resolved against the manifest's folder.
+    */
+    static juce::Result parseManifest (const juce::File& manifest,
+                                       const RenderSettings& defaults,
+                                       std::vector<BatchJob>& jobs);
+
+    /** Renders every job and returns their results in the same order.
+        numThreads <= 0 uses one worker per logical core.
+    */
+    static std::vector<BatchResult> run (const std::vector<BatchJob>& jobs, int numThreads = 0);
+};
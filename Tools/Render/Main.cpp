@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Command line front end for OfflineRenderer.
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+
+namespace
+{
+    void printUsage (const juce::String& name)
+    {
+        std::cout << "Usage: " << name << " [options] <input> <output>" << std::endl
+                  << "       " << name << " [options] --manifest=<jobs.json> [--threads=<n>]" << std::endl
+                  << std::endl
+                  << "  --amount=<0..100>       Amount in percent (default 0)" << std::endl
+                  << "  --threshold=<dB>        Glue compressor threshold, -70..6 (default 0)" << std::endl
+                  << "  --makeup=<dB>           Makeup gain, 0..20 (default 0)" << std::endl
+                  << "  --oversampling=<1|2|4|8> Saturator oversampling factor (default 1)" << std::endl
+                  << "  --linear-phase          Use linear phase oversampling filters" << std::endl
+                  << "  --glue-link=<off|max|sum> Glue compressor detector across channels (default off)" << std::endl
+                  << "  --band-link=<off|max|sum> Band compressor detectors across channels (default off)" << std::endl
+                  << "  --limit                 Brickwall limiter at the end of the chain" << std::endl
+                  << "  --ceiling=<dB>          Limiter ceiling, -12..0 (default -0.3)" << std::endl
+                  << "  --lookahead=<ms>        Limiter lookahead, 0.5..5 (default 1.5)" << std::endl
+                  << "  --parallel              Spread each block over a few threads (with --block=4096 or more)" << std::endl
+                  << "  --block=<samples>       Samples processed per step (default 512)" << std::endl
+                  << "  --manifest=<file>       Render every job in a JSON manifest in parallel;" << std::endl
+                  << "                          the options above become the manifest's defaults" << std::endl
+                  << "  --threads=<n>           Worker threads for --manifest (default: one per core)" << std::endl
+                  << std::endl
+                  << "The output format is chosen from the output file's extension." << std::endl;
+    }
+
+    bool parseSettings (const juce::ArgumentList& args, RenderSettings& settings, juce::String& error)
+    {
+        auto getFloat = [&args] (juce::StringRef option, float defaultValue, float minValue, float maxValue)
+        {
+            auto text = args.getValueForOption(option);
+            return text.isEmpty() ? defaultValue : juce::jlimit(minValue, maxValue, text.getFloatValue());
+        };
+
+        settings.parameters.amount = getFloat("--amount", 0.0f, 0.0f, 100.0f);
+        settings.parameters.threshold = getFloat("--threshold", 0.0f, -70.0f, 6.0f);
+        settings.parameters.makeup = getFloat("--makeup", 0.0f, 0.0f, 20.0f);
+        settings.parameters.linearPhase = args.containsOption("--linear-phase");
+        settings.parameters.limiter = args.containsOption("--limit");
+        settings.parallel = args.containsOption("--parallel");
+        settings.parameters.ceiling = getFloat("--ceiling", -0.3f, -12.0f, 0.0f);
+        settings.parameters.lookahead = getFloat("--lookahead", 1.5f, 0.5f, 5.0f);
+
+        auto factor = args.getValueForOption("--oversampling");
+
+        if( factor.isNotEmpty() )
+        {
+            auto order = juce::StringArray { "1", "2", "4", "8" }.indexOf(factor.trim());
+
+            if( order < 0 )
+            {
+                error = "--oversampling must be 1, 2, 4 or 8";
+                return false;
+            }
+
+            settings.parameters.oversamplingOrder = order;
+        }
+
+        for( auto* option : { "--glue-link", "--band-link" } )
+        {
+            auto mode = args.getValueForOption(option);
+
+            if( mode.isEmpty() )
+                continue;
+
+            auto link = juce::StringArray { "off", "max", "sum" }.indexOf(mode.trim());
+
+            if( link < 0 )
+            {
+                error = juce::String(option) + " must be off, max or sum";
+                return false;
+            }
+
+            (juce::String(option) == "--glue-link" ? settings.parameters.glueLink : settings.parameters.bandLink) = (DetectorLink) link;
+        }
+
+        auto block = args.getValueForOption("--block");
+
+        if( block.isNotEmpty() )
+        {
+            settings.blockSize = block.getIntValue();
+
+            if( settings.blockSize < 1 )
+            {
+                error = "--block must be a positive number of samples";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int renderManifest (const juce::ArgumentList& args, const RenderSettings& defaults)
+    {
+        if( args.getValueForOption("--manifest").isEmpty() )
+        {
+            std::cerr << "--manifest needs a file name" << std::endl;
+            return 1;
+        }
+
+        std::vector<BatchJob> jobs;
+        auto parsed = BatchRenderer::parseManifest(args.getFileForOption("--manifest"), defaults, jobs);
+
+        if( parsed.failed() )
+        {
+            std::cerr << parsed.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        auto results = BatchRenderer::run(jobs, args.getValueForOption("--threads").getIntValue());
+        auto wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        auto audioSeconds = 0.0;
+        auto numFailed = 0;
+
+        for( size_t i = 0; i < jobs.size(); ++i )
+        {
+            const auto& result = results[i];
+
+            if( result.result.failed() )
+            {
+                ++numFailed;
+                std::cerr << "FAILED  " << result.result.getErrorMessage() << std::endl;
+                continue;
+            }
+
+            audioSeconds += result.stats.audioSeconds;
+
+            std::cout << juce::String(result.stats.getRealtimeFactor(), 1).paddedLeft(' ', 8) << "x  "
+                      << juce::String(result.stats.audioSeconds, 1).paddedLeft(' ', 8) << " s  "
+                      << jobs[i].input.getFileName() << std::endl;
+        }
+
+        //per file numbers are per core; the overall one is what the batch achieved
+        std::cout << std::endl
+                  << jobs.size() - (size_t) numFailed << " of " << jobs.size() << " files, "
+                  << juce::String(audioSeconds, 1) << " s of audio in "
+                  << juce::String(wallSeconds, 2) << " s: "
+                  << juce::String(wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1) << "x realtime overall" << std::endl;
+
+        return numFailed == 0 ? 0 : 1;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if( args.containsOption("--help|-h") )
+    {
+        printUsage(args.executableName);
+        return 0;
+    }
+
+    RenderSettings settings;
+    juce::String error;
+
+    if( ! parseSettings(args, settings, error) )
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if( args.containsOption("--manifest") )
+        return renderManifest(args, settings);
+
+    juce::StringArray files;
+
+    for( auto& arg : args.arguments )
+        if( ! arg.isOption() )
+            files.add(arg.text);
+
+    if( files.size() != 2 )
+    {
+        printUsage(args.executableName);
+        return 1;
+    }
+
+    OfflineRenderer renderer;
+    CompressorPieceDSP<float> dsp;
+
+    auto result = renderer.render(dsp,
+                                  juce::File::getCurrentWorkingDirectory().getChildFile(files[0]),
+                                  juce::File::getCurrentWorkingDirectory().getChildFile(files[1]),
+                                  settings);
+
+    if( result.failed() )
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+OfflineRenderer::OfflineRenderer()
+{
+    formatManager.registerBasicFormats();
+}
+
+std::unique_ptr<juce::AudioFormatReader> OfflineRenderer::createReader (const juce::File& source)
+{
+    //only mapping the file reserves address space; pages are read as the
+    //render touches them
+    if( auto* format = formatManager.findFormatForFileExtension(source.getFileExtension()) )
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped (format->createMemoryMappedReader(source));
+
+        if( mapped != nullptr && mapped->mapEntireFile() && ! mapped->getMappedSection().isEmpty() )
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader> (formatManager.createReaderFor(source));
+}
+
+juce::Result OfflineRenderer::render (CompressorPieceDSP<float>& dsp,
+                                      const juce::File& source,
+                                      const juce::File& destination,
+                                      const RenderSettings& settings,
+                                      RenderStats* stats)
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    auto reader = createReader(source);
+
+    if( reader == nullptr )
+        return juce::Result::fail("Can't read " + source.getFullPathName());
+
+    auto* format = formatManager.findFormatForFileExtension(destination.getFileExtension());
+
+    if( format == nullptr )
+        return juce::Result::fail("No writable format for " + destination.getFullPathName());
+
+    //keep the source's bit depth where the destination format supports it
+    auto bitsPerSample = (int) reader->bitsPerSample;
+
+    if( ! format->getPossibleBitDepths().contains(bitsPerSample) )
+        bitsPerSample = 24;
+
+    destination.deleteFile();
+    auto stream = destination.createOutputStream();
+
+    if( stream == nullptr )
+        return juce::Result::fail("Can't write " + destination.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor(stream.get(),
+                                                                             reader->sampleRate,
+                                                                             reader->numChannels,
+                                                                             bitsPerSample,
+                                                                             {},
+                                                                             0));
+
+    if( writer == nullptr )
+        return juce::Result::fail("Can't create a " + format->getFormatName() + " writer for " + destination.getFullPathName());
+
+    //the writer owns the stream from here on
+    stream.release();
+
+    auto blockSize = juce::jmax(1, settings.blockSize);
+    auto numChannels = (int) reader->numChannels;
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = reader->sampleRate;
+    spec.maximumBlockSize = (juce::uint32) blockSize;
+    spec.numChannels = (juce::uint32) numChannels;
+
+    //parameters first, so the render starts on them instead of gliding in
+    dsp.setParameters(settings.parameters);
+
+    if( settings.parallel )
+        dsp.attachTaskPool();
+
+    dsp.setParallelProcessing(settings.parallel);
+    dsp.prepare(spec);
+    dsp.reset();
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+    //once the file runs out the buffer is filled with silence, which is what
+    //flushes the latency; reads never go past the end, which not every reader
+    //(a memory mapped one, for one) allows
+    juce::int64 readPosition = 0;
+    juce::int64 samplesToSkip = dsp.getLatencySamples();
+    juce::int64 samplesToWrite = reader->lengthInSamples;
+
+    while( samplesToWrite > 0 )
+    {
+        auto numToRead = (int) juce::jlimit((juce::int64) 0, (juce::int64) blockSize, reader->lengthInSamples - readPosition);
+
+        if( numToRead > 0 && ! reader->read(&buffer, 0, numToRead, readPosition, true, true) )
+            return juce::Result::fail("Read error in " + source.getFullPathName());
+
+        if( numToRead < blockSize )
+            buffer.clear(numToRead, blockSize - numToRead);
+
+        readPosition += numToRead;
+
+        dsp.process(juce::dsp::AudioBlock<float> (buffer));
+
+        auto start = (int) juce::jmin(samplesToSkip, (juce::int64) blockSize);
+        samplesToSkip -= start;
+
+        auto numToWrite = (int) juce::jmin(samplesToWrite, (juce::int64) (blockSize - start));
+
+        if( numToWrite > 0 )
+        {
+            if( ! writer->writeFromAudioSampleBuffer(buffer, start, numToWrite) )
+                return juce::Result::fail("Write error in " + destination.getFullPathName());
+
+            samplesToWrite -= numToWrite;
+        }
+    }
+
+    //flush before timing so the realtime factor includes getting it to disk
+    writer.reset();
+
+    if( stats != nullptr )
+    {
+        stats->audioSeconds = (double) reader->lengthInSamples / reader->sampleRate;
+        stats->wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "CompressorPieceDSP.h"
+
+//==============================================================================
+/** Parameter values and streaming options for one render. */
+struct RenderSettings
+{
+    //handed to the chain as they are, so a new parameter needs no renderer changes
+    CompressorPieceParameters parameters;
+
+    //split big blocks across the shared TaskPool; only pays off from 4096 samples
+    bool parallel { false };
+
+    //samples read, processed and written per step; the only audio ever held
+    int blockSize { 512 };
+};
+
+/** What a render cost, for realtime factor reporting. */
+struct RenderStats
+{
+    double audioSeconds { 0.0 };
+    double wallSeconds { 0.0 };
+
+    double getRealtimeFactor () const noexcept { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+};
+
+//==============================================================================
+/**
+    Streams one audio file through CompressorPieceDSP into another.
+
+    Input is pulled from the reader one block at a time and each processed
+    block is written straight out, so memory use does not depend on the file
+    length. WAV and AIFF sources are memory-mapped rather than read through a
+    stream, so the OS pages them in on demand and several renderers can read
+    at once without contending on buffered file I/O. The oversampling latency is trimmed from the start and flushed at
+    the end, so the output lines up with the input sample for sample. The
+    output format follows the destination's file extension (.wav, .aif,
+    .aiff, ...).
+*/
+class OfflineRenderer
+{
+public:
+    OfflineRenderer();
+
+    /** Renders source into destination, replacing it. dsp is prepared for the
+        file's sample rate and channel count, so one instance can be reused.
+    */
+    juce::Result render (CompressorPieceDSP<float>& dsp,
+                         const juce::File& source,
+                         const juce::File& destination,
+                         const RenderSettings& settings,
+                         RenderStats* stats = nullptr);
+
+private:
+    std::unique_ptr<juce::AudioFormatReader> createReader (const juce::File& source);
+
+    juce::AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE (OfflineRenderer)
+};